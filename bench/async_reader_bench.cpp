@@ -0,0 +1,92 @@
+#include "task.h"
+#include "harness.h"
+#include "memory_backend.h"
+#include "patron/services/executor.h"
+#include "patron/services/module_service.h"
+#include "patron/utils/throw.h"
+#include <format>
+#include <latch>
+#include <memory>
+#include <stdexcept>
+
+namespace patron
+{
+    namespace bench
+    {
+        namespace async_reader_commands
+        {
+            struct module_0 : patron::module_base
+            {
+                [[=patron::command{"Whois"}]]
+                task<command_result> whois(user target) { co_return command_result::from_success(); }
+            };
+        }
+
+        namespace
+        {
+            constexpr std::size_t concurrent_dispatches = 50;
+
+            task<bool> dispatch(module_service<task>& service, std::string_view message, std::latch& done)
+            {
+                command_result result = co_await service.run_command(message);
+                done.count_down();
+                co_return result.success();
+            }
+
+            // one op is one dispatch. they're started concurrent_dispatches at a time by one job on a single worker,
+            // and the job the reader posts when it opens a batch only runs after that, so batching across dispatches
+            // turns that many round trips into one. each round checks the backend saw as many as it should have.
+            void add_async_reader(suite& suite, std::string name, std::size_t max_batch)
+            {
+                auto backend = std::make_shared<memory_backend>();
+                for (std::uint64_t id = 0; id < concurrent_dispatches; ++id)
+                    backend->insert(user { id, std::format("user{}", id) });
+
+                auto exec = std::make_shared<executor>(1);
+                auto service = std::make_shared<module_service<task>>();
+                service->register_extra_data(backend.get());
+                service->register_extra_data(batch_window { max_batch, exec.get() });
+                service->register_async_type_reader<user_reader>();
+                service->register_namespace<^^async_reader_commands>();
+
+                auto messages = std::make_shared<std::vector<std::string>>();
+                for (std::size_t i = 0; i < concurrent_dispatches; ++i)
+                    messages->push_back(std::format("!Whois <@{}>", i));
+
+                suite.add(std::move(name), [backend, exec, service, messages, max_batch](std::size_t iterations) {
+                    std::vector<task<bool>> tasks;
+                    tasks.reserve(concurrent_dispatches);
+                    for (std::size_t done = 0; done < iterations; done += tasks.size())
+                    {
+                        const std::size_t count = std::min(concurrent_dispatches, iterations - done);
+                        const std::size_t round_trips = backend->round_trips();
+                        std::latch finished(static_cast<std::ptrdiff_t>(count));
+
+                        tasks.clear();
+                        for (std::size_t i = 0; i < count; ++i)
+                            tasks.push_back(dispatch(*service, (*messages)[i], finished));
+                        exec->post([&tasks] {
+                            for (task<bool>& task : tasks)
+                                task.start();
+                        });
+                        // the dispatches count down before they return, the job they finished in is done after this
+                        finished.wait();
+                        exec->submit([] {}).get();
+
+                        for (task<bool>& task : tasks)
+                            do_not_optimize(std::move(task).result());
+
+                        if (backend->round_trips() - round_trips != (count + max_batch - 1) / max_batch)
+                            utility::throw_exception(std::logic_error("Reads weren't batched as configured"));
+                    }
+                });
+            }
+        }
+
+        void add_async_reader_benchmarks(suite& suite)
+        {
+            add_async_reader(suite, "async_reader/unbatched", 1);
+            add_async_reader(suite, std::format("async_reader/batched_{}", concurrent_dispatches), concurrent_dispatches);
+        }
+    }
+}
@@ -0,0 +1,144 @@
+#pragma once
+#include "patron/commands/preconditions.h"
+#include "patron/modules/module_base.h"
+#include "patron/results/command_result.h"
+#include "task.h"
+#include <string>
+#include <vector>
+
+// modules of ten commands each, named Cmd<module>_<command> and taking one int, generated so the lookup and dispatch
+// benchmarks can be run against command sets of different sizes
+#define PATRON_BENCH_COMMAND(m, c) \
+    [[=patron::command{"Cmd" #m "_" #c}]] \
+    patron::command_result cmd##c(int value) { return patron::command_result::from_success(); }
+
+#define PATRON_BENCH_COMMANDS(m) \
+    PATRON_BENCH_COMMAND(m, 0) PATRON_BENCH_COMMAND(m, 1) PATRON_BENCH_COMMAND(m, 2) \
+    PATRON_BENCH_COMMAND(m, 3) PATRON_BENCH_COMMAND(m, 4) PATRON_BENCH_COMMAND(m, 5) \
+    PATRON_BENCH_COMMAND(m, 6) PATRON_BENCH_COMMAND(m, 7) PATRON_BENCH_COMMAND(m, 8) \
+    PATRON_BENCH_COMMAND(m, 9)
+
+#define PATRON_BENCH_MODULE(m) \
+    struct module_##m : patron::module_base \
+    { \
+        PATRON_BENCH_COMMANDS(m) \
+    };
+
+// the same, but each module also sets up 16 KiB of state when it's constructed, like a cache or lookup table a real
+// module would fill in, so the startup benchmarks see what constructing modules up front costs
+#define PATRON_BENCH_HEAVY_MODULE(m) \
+    struct module_##m : patron::module_base \
+    { \
+        std::vector<int> state = std::vector<int>(4096); \
+        PATRON_BENCH_COMMANDS(m) \
+    };
+
+#define PATRON_BENCH_HEAVY_MODULES_10(p) \
+    PATRON_BENCH_HEAVY_MODULE(p##0) PATRON_BENCH_HEAVY_MODULE(p##1) PATRON_BENCH_HEAVY_MODULE(p##2) \
+    PATRON_BENCH_HEAVY_MODULE(p##3) PATRON_BENCH_HEAVY_MODULE(p##4) PATRON_BENCH_HEAVY_MODULE(p##5) \
+    PATRON_BENCH_HEAVY_MODULE(p##6) PATRON_BENCH_HEAVY_MODULE(p##7) PATRON_BENCH_HEAVY_MODULE(p##8) \
+    PATRON_BENCH_HEAVY_MODULE(p##9)
+
+#define PATRON_BENCH_MODULES_10(p) \
+    PATRON_BENCH_MODULE(p##0) PATRON_BENCH_MODULE(p##1) PATRON_BENCH_MODULE(p##2) PATRON_BENCH_MODULE(p##3) \
+    PATRON_BENCH_MODULE(p##4) PATRON_BENCH_MODULE(p##5) PATRON_BENCH_MODULE(p##6) PATRON_BENCH_MODULE(p##7) \
+    PATRON_BENCH_MODULE(p##8) PATRON_BENCH_MODULE(p##9)
+
+namespace patron
+{
+    namespace bench
+    {
+        namespace commands_10
+        {
+            PATRON_BENCH_MODULE(0)
+        }
+
+        namespace commands_100
+        {
+            PATRON_BENCH_MODULES_10()
+        }
+
+        namespace commands_1000
+        {
+            PATRON_BENCH_MODULES_10() PATRON_BENCH_MODULES_10(1) PATRON_BENCH_MODULES_10(2)
+            PATRON_BENCH_MODULES_10(3) PATRON_BENCH_MODULES_10(4) PATRON_BENCH_MODULES_10(5)
+            PATRON_BENCH_MODULES_10(6) PATRON_BENCH_MODULES_10(7) PATRON_BENCH_MODULES_10(8)
+            PATRON_BENCH_MODULES_10(9)
+        }
+
+        namespace heavy_commands_1000
+        {
+            PATRON_BENCH_HEAVY_MODULES_10() PATRON_BENCH_HEAVY_MODULES_10(1) PATRON_BENCH_HEAVY_MODULES_10(2)
+            PATRON_BENCH_HEAVY_MODULES_10(3) PATRON_BENCH_HEAVY_MODULES_10(4) PATRON_BENCH_HEAVY_MODULES_10(5)
+            PATRON_BENCH_HEAVY_MODULES_10(6) PATRON_BENCH_HEAVY_MODULES_10(7) PATRON_BENCH_HEAVY_MODULES_10(8)
+            PATRON_BENCH_HEAVY_MODULES_10(9)
+        }
+
+        namespace precondition_commands
+        {
+            // a static precondition that lets everyone but user 0 through
+            struct not_anonymous
+            {
+                precondition_result check(const command_context& context) const
+                {
+                    return context.user ? precondition_result::from_success()
+                                        : precondition_result::from_error("Anonymous users can't run this");
+                }
+            };
+
+            struct module_0 : patron::module_base
+            {
+                // generous enough that the benchmark never runs out, so every dispatch pays for taking a use
+                [[=not_anonymous{}, =patron::cooldown{.uses = 1'000'000, .period_ms = 1}]]
+                [[=patron::command{"Cmd0_0"}]]
+                command_result cmd0(int value) { return command_result::from_success(); }
+            };
+        }
+
+        // routed through two groups, to compare against the flat commands of the same module count
+        namespace grouped_commands
+        {
+            struct [[=patron::group{"Admin"}]] module_0 : patron::module_base
+            {
+                [[=patron::group{"User"}, =patron::command{"Set"}]]
+                command_result set(int value) { return command_result::from_success(); }
+            };
+
+            PATRON_BENCH_MODULES_10(1)
+        }
+
+        // overloads of one command, where the two int arguments only fit the last one
+        namespace overload_commands
+        {
+            struct module_0 : patron::module_base
+            {
+                [[=patron::command{"Find"}]]
+                command_result find_text(std::string text) { return command_result::from_success(); }
+
+                [[=patron::command{"Find"}]]
+                command_result find_id(int id) { return command_result::from_success(); }
+
+                [[=patron::command{"Find"}]]
+                command_result find_range(int from, int to) { return command_result::from_success(); }
+            };
+        }
+
+        namespace async_commands
+        {
+            struct module_0 : patron::module_base
+            {
+                [[=patron::command{"Cmd0_0"}]]
+                task<command_result> cmd0(int value) { co_return command_result::from_success(); }
+            };
+        }
+
+        namespace pooled_async_commands
+        {
+            struct module_0 : patron::module_base
+            {
+                [[=patron::command{"Cmd0_0"}]]
+                pooled_task<command_result> cmd0(int value) { co_return command_result::from_success(); }
+            };
+        }
+    }
+}
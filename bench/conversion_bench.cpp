@@ -0,0 +1,174 @@
+#include "harness.h"
+#include "patron/services/module_service.h"
+#include "patron/utils/enum_parser.h"
+#include "patron/utils/integer_list.h"
+#include "patron/utils/lexical_cast.h"
+#include <chrono>
+#include <format>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace patron
+{
+    namespace bench
+    {
+        namespace
+        {
+            struct point
+            {
+                int x;
+                int y;
+            };
+
+            // reads "x,y", the shape of a typical user-written reader
+            struct point_reader : type_reader<point_reader, point>
+            {
+                type_reader_result read(std::string_view input) override
+                {
+                    const std::size_t comma = input.find(',');
+                    if (comma == std::string_view::npos)
+                        return type_reader_result::from_error(command_error::parse_failed, "Expected x,y");
+
+                    std::expected<int, std::errc> x = utility::try_lexical_cast<int>(input.substr(0, comma));
+                    std::expected<int, std::errc> y = utility::try_lexical_cast<int>(input.substr(comma + 1));
+                    if (!x || !y)
+                        return type_reader_result::from_error(command_error::parse_failed, "Expected x,y");
+
+                    add_result(point { *x, *y });
+                    return type_reader_result::from_success();
+                }
+            };
+
+            enum class color { red, green, blue, cyan, magenta, yellow, black, white };
+
+            // the same point, read from two arguments by the built-in fields conversion instead of a reader
+            struct [[=patron::fields{}]] point_fields
+            {
+                int x;
+                int y;
+            };
+
+            struct builtin_module : module_base
+            {
+                [[=patron::command{"Paint"}]]
+                command_result paint(color value) { return command_result::from_success(); }
+
+                [[=patron::command{"Move"}]]
+                command_result move(point_fields to) { return command_result::from_success(); }
+
+                [[=patron::command{"Sum"}]]
+                command_result sum(std::vector<int> values) { return command_result::from_success(); }
+
+                [[=patron::command{"Ban"}]]
+                command_result ban(std::vector<std::uint64_t> ids) { return command_result::from_success(); }
+            };
+
+            // a hundred snowflake-sized ids, the kind of list a moderation command is handed
+            std::vector<std::string> make_ids()
+            {
+                std::vector<std::string> ids;
+                for (std::uint64_t i = 0; i < 100; ++i)
+                    ids.push_back(std::to_string(1000000000000000000ull + i * 7919000023ull));
+                return ids;
+            }
+
+            template<typename T>
+            void add_lexical_cast(suite& suite, std::string_view type_name, std::string_view input)
+            {
+                suite.add(std::format("lexical_cast/{}", type_name), [input](std::size_t iterations) {
+                    for (std::size_t i = 0; i < iterations; ++i)
+                    {
+                        std::string_view arg = input;
+                        do_not_optimize(arg);
+                        do_not_optimize(utility::try_lexical_cast<T>(arg));
+                    }
+                });
+            }
+        }
+
+        void add_conversion_benchmarks(suite& suite)
+        {
+            add_lexical_cast<signed char>(suite, "signed char", "-42");
+            add_lexical_cast<unsigned char>(suite, "unsigned char", "200");
+            add_lexical_cast<short>(suite, "short", "-12345");
+            add_lexical_cast<unsigned short>(suite, "unsigned short", "54321");
+            add_lexical_cast<int>(suite, "int", "-1234567");
+            add_lexical_cast<unsigned int>(suite, "unsigned int", "3456789012");
+            add_lexical_cast<long>(suite, "long", "-1234567890123");
+            add_lexical_cast<unsigned long>(suite, "unsigned long", "12345678901234");
+            add_lexical_cast<long long>(suite, "long long", "-1234567890123456");
+            add_lexical_cast<unsigned long long>(suite, "unsigned long long", "12345678901234567890");
+            add_lexical_cast<float>(suite, "float", "3.14159");
+            add_lexical_cast<double>(suite, "double", "2.718281828459045");
+            add_lexical_cast<long double>(suite, "long double", "1.4142135623730950488");
+            add_lexical_cast<int>(suite, "int/hex", "-0x12d687");
+            add_lexical_cast<bool>(suite, "bool", "Off");
+            add_lexical_cast<char>(suite, "char", "x");
+            add_lexical_cast<std::chrono::seconds>(suite, "seconds", "1h30m15s");
+
+            auto service = std::make_shared<module_service<>>();
+            service->register_type_reader<point_reader>();
+            suite.add("type_reader/point", [service](std::size_t iterations) {
+                for (std::size_t i = 0; i < iterations; ++i)
+                {
+                    type_reader_base<point>* reader = service->get_type_reader<point>();
+                    do_not_optimize(reader->read("12,-34").success());
+                    do_not_optimize(reader->top_result());
+                }
+            });
+
+            suite.add("parse_enum/case_insensitive", [](std::size_t iterations) {
+                for (std::size_t i = 0; i < iterations; ++i)
+                {
+                    std::string_view arg = "Magenta";
+                    do_not_optimize(arg);
+                    do_not_optimize(utility::parse_enum<color>(arg, false));
+                }
+            });
+
+            auto ids = std::make_shared<const std::vector<std::string>>(make_ids());
+            auto tokens = std::make_shared<const std::vector<std::string_view>>(ids->begin(), ids->end());
+            suite.add("integer_list/100", [tokens](std::size_t iterations) {
+                std::vector<std::uint64_t> values;
+                for (std::size_t i = 0; i < iterations; ++i)
+                {
+                    values.clear();
+                    do_not_optimize(utility::parse_integers(std::span(*tokens), values).has_value());
+                    do_not_optimize(values.data());
+                }
+            });
+            suite.add("integer_list/100/lexical_cast", [tokens](std::size_t iterations) {
+                std::vector<std::uint64_t> values;
+                for (std::size_t i = 0; i < iterations; ++i)
+                {
+                    values.clear();
+                    for (std::string_view token : *tokens)
+                        values.push_back(*utility::try_lexical_cast<std::uint64_t>(token));
+                    do_not_optimize(values.data());
+                }
+            });
+
+            auto builtin_service = std::make_shared<module_service<>>();
+            builtin_service->register_module<builtin_module>();
+            for (auto [name, message] : { std::pair { "enum", "!Paint magenta" },
+                                          std::pair { "fields", "!Move 12 -34" },
+                                          std::pair { "list/10", "!Sum 1 2 3 4 5 6 7 8 9 10" } })
+            {
+                suite.add(std::format("run_command/builtin/{}", name), [builtin_service, message](std::size_t iterations) {
+                    for (std::size_t i = 0; i < iterations; ++i)
+                        do_not_optimize(builtin_service->run_command(message).success());
+                });
+            }
+
+            std::string ban = "!Ban";
+            for (const std::string& id : *ids)
+                ban += ' ' + id;
+            suite.add("run_command/builtin/list/100", [builtin_service, ban](std::size_t iterations) {
+                for (std::size_t i = 0; i < iterations; ++i)
+                    do_not_optimize(builtin_service->run_command(ban).success());
+            });
+        }
+    }
+}
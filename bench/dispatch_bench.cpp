@@ -0,0 +1,110 @@
+#include "bench_modules.h"
+#include "harness.h"
+#include "patron/services/module_service.h"
+#include "patron/services/static_module_service.h"
+#include <algorithm>
+#include <array>
+#include <format>
+#include <memory>
+#include <thread>
+
+namespace patron
+{
+    namespace bench
+    {
+        namespace
+        {
+            template<typename Service>
+            void add_run_command(suite& suite, std::string name, std::shared_ptr<Service> service, std::string_view message)
+            {
+                suite.add(std::move(name), [service, message](std::size_t iterations) {
+                    for (std::size_t i = 0; i < iterations; ++i)
+                        do_not_optimize(service->run_command(message).success());
+                });
+            }
+
+            // splits the iterations across threads dispatching against one service, so ns/op is wall time per
+            // dispatch and should fall in proportion to the thread count while scaling holds
+            void add_concurrent_run_command(suite& suite, std::shared_ptr<module_service<>> service, unsigned threads)
+            {
+                suite.add(std::format("run_command/concurrent/{}_threads", threads), [service, threads](std::size_t iterations) {
+                    std::vector<std::jthread> workers;
+                    for (unsigned t = 0; t < threads; ++t)
+                    {
+                        const std::size_t count = iterations / threads + (t < iterations % threads);
+                        workers.emplace_back([&service, count] {
+                            for (std::size_t i = 0; i < count; ++i)
+                                do_not_optimize(service->run_command("!Cmd5_3 42").success());
+                        });
+                    }
+                });
+            }
+        }
+
+        void add_dispatch_benchmarks(suite& suite)
+        {
+            auto service_100 = std::make_shared<module_service<>>();
+            service_100->register_namespace<^^commands_100>();
+            add_run_command(suite, "run_command/sync/100", service_100, "!Cmd5_3 42");
+            add_run_command(suite, "run_command/sync/100/quoted", service_100, "!Cmd5_3 \"42\"");
+            add_run_command(suite, "run_command/sync/100/bad_argument", service_100, "!Cmd5_3 abc");
+            add_run_command(suite, "run_command/sync/100/unknown", service_100, "!nope 42");
+
+            auto service_1000 = std::make_shared<module_service<>>();
+            service_1000->register_namespace<^^commands_1000>();
+            add_run_command(suite, "run_command/sync/1000", service_1000, "!Cmd57_3 42");
+
+            auto grouped_service = std::make_shared<module_service<>>();
+            grouped_service->register_namespace<^^grouped_commands>();
+            add_run_command(suite, "run_command/sync/grouped", grouped_service, "!Admin User Set 42");
+
+            auto overload_service = std::make_shared<module_service<>>();
+            overload_service->register_namespace<^^overload_commands>();
+            add_run_command(suite, "run_command/sync/overloads", overload_service, "!Find 42 7");
+
+            auto static_service = std::make_shared<static_module_service<commands_10::module_0>>();
+            add_run_command(suite, "run_command/static/10", static_service, "!Cmd0_3 42");
+
+            // one op is one message, run in batches of 64
+            suite.add("run_commands/sync/100/batch_64", [service_100](std::size_t iterations) {
+                static const std::vector<std::string_view> batch(64, "!Cmd5_3 42");
+                for (std::size_t done = 0; done < iterations; done += batch.size())
+                    do_not_optimize(service_100->run_commands(std::span(batch).first(std::min(batch.size(), iterations - done))).size());
+            });
+
+            // one user per dispatch out of 1000, so the cooldown buckets are spread over the table's shards
+            auto precondition_service = std::make_shared<module_service<>>();
+            precondition_service->register_namespace<^^precondition_commands>();
+            suite.add("run_command/sync/preconditions", [precondition_service](std::size_t iterations) {
+                for (std::size_t i = 0; i < iterations; ++i)
+                    do_not_optimize(precondition_service->run_command("!Cmd0_0 42", command_context { 1 + i % 1000 }).success());
+            });
+
+            suite.add("run_command/sync/100/span", [service_100](std::size_t iterations) {
+                static constexpr std::array<std::string_view, 1> args { "42" };
+                for (std::size_t i = 0; i < iterations; ++i)
+                    do_not_optimize(service_100->run_command("Cmd5_3", args).success());
+            });
+
+            const unsigned max_threads = std::max(1u, std::thread::hardware_concurrency());
+            for (unsigned threads = 1; threads < max_threads; threads *= 2)
+                add_concurrent_run_command(suite, service_100, threads);
+            add_concurrent_run_command(suite, service_100, max_threads);
+
+            auto async_service = std::make_shared<module_service<task>>();
+            async_service->register_namespace<^^async_commands>();
+            suite.add("run_command/coroutine/1", [async_service](std::size_t iterations) {
+                for (std::size_t i = 0; i < iterations; ++i)
+                    do_not_optimize(async_service->run_command("!Cmd0_0 42").get().success());
+            });
+
+            // the same dispatch with both the library's frame and the command's coming from the frame pool
+            auto pooled_service = std::make_shared<module_service<pooled_task>>();
+            pooled_service->register_namespace<^^pooled_async_commands>();
+            suite.add("run_command/coroutine_pooled/1", [pooled_service](std::size_t iterations) {
+                for (std::size_t i = 0; i < iterations; ++i)
+                    do_not_optimize(pooled_service->run_command("!Cmd0_0 42").get().success());
+            });
+        }
+    }
+}
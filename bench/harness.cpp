@@ -0,0 +1,116 @@
+#include "harness.h"
+#include "patron/utils/throw.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <format>
+#include <iostream>
+#include <new>
+
+namespace
+{
+    std::atomic<std::size_t> allocations;
+    std::atomic<std::size_t> allocated_bytes;
+
+    void* counted_alloc(std::size_t size, std::size_t alignment)
+    {
+        allocations.fetch_add(1, std::memory_order_relaxed);
+        allocated_bytes.fetch_add(size, std::memory_order_relaxed);
+
+        if (size == 0)
+            size = 1;
+
+        void* ptr = alignment > alignof(std::max_align_t)
+            ? std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment)
+            : std::malloc(size);
+        if (!ptr)
+            patron::utility::throw_exception(std::bad_alloc());
+        return ptr;
+    }
+}
+
+void* operator new(std::size_t size) { return counted_alloc(size, alignof(std::max_align_t)); }
+void* operator new[](std::size_t size) { return counted_alloc(size, alignof(std::max_align_t)); }
+void* operator new(std::size_t size, std::align_val_t al) { return counted_alloc(size, static_cast<std::size_t>(al)); }
+void* operator new[](std::size_t size, std::align_val_t al) { return counted_alloc(size, static_cast<std::size_t>(al)); }
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+void operator delete[](void* ptr) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::size_t) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, std::size_t) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::align_val_t) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, std::align_val_t) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::size_t, std::align_val_t) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, std::size_t, std::align_val_t) noexcept { std::free(ptr); }
+
+namespace patron
+{
+    namespace bench
+    {
+        namespace
+        {
+            constexpr std::chrono::milliseconds min_duration(200);
+        }
+
+        std::size_t allocation_count()
+        {
+            return allocations.load(std::memory_order_relaxed);
+        }
+
+        std::size_t allocated_byte_count()
+        {
+            return allocated_bytes.load(std::memory_order_relaxed);
+        }
+
+        void suite::add(std::string name, benchmark_fn fn)
+        {
+            m_entries.emplace_back(std::move(name), std::move(fn));
+        }
+
+        void suite::run(std::string_view filter) const
+        {
+            using clock = std::chrono::steady_clock;
+
+            std::cout << std::format("{:<56} {:>12} {:>12} {:>12} {:>12}\n",
+                "benchmark", "ns/op", "allocs/op", "bytes/op", "iterations");
+            for (const entry& entry : m_entries)
+            {
+                if (!entry.name.contains(filter))
+                    continue;
+
+                // warm up caches and any lazily created state, so the timed runs only see the steady state
+                entry.fn(1);
+
+                // grow the iteration count until a run takes long enough to time reliably
+                std::size_t iterations = 1;
+                clock::duration elapsed{};
+                std::size_t allocs = 0;
+                std::size_t bytes = 0;
+                while (true)
+                {
+                    const std::size_t allocs_before = allocation_count();
+                    const std::size_t bytes_before = allocated_byte_count();
+                    const clock::time_point start = clock::now();
+                    entry.fn(iterations);
+                    elapsed = clock::now() - start;
+                    allocs = allocation_count() - allocs_before;
+                    bytes = allocated_byte_count() - bytes_before;
+
+                    if (elapsed >= min_duration || iterations >= (std::size_t(1) << 40))
+                        break;
+
+                    const double scale = elapsed.count() > 0
+                        ? static_cast<double>(min_duration.count()) * 1.2 /
+                          std::chrono::duration<double, std::milli>(elapsed).count()
+                        : 10.0;
+                    iterations = static_cast<std::size_t>(static_cast<double>(iterations) * std::clamp(scale, 2.0, 10.0));
+                }
+
+                const double ns = std::chrono::duration<double, std::nano>(elapsed).count() / static_cast<double>(iterations);
+                std::cout << std::format("{:<56} {:>12.1f} {:>12.2f} {:>12.0f} {:>12}\n",
+                    entry.name, ns, static_cast<double>(allocs) / static_cast<double>(iterations),
+                    static_cast<double>(bytes) / static_cast<double>(iterations), iterations);
+            }
+        }
+    }
+}
@@ -0,0 +1,52 @@
+#pragma once
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace patron
+{
+    namespace bench
+    {
+        // allocations made through the global operator new since the program started, counted by the replacements
+        // in harness.cpp
+        std::size_t allocation_count();
+        // bytes requested by those allocations, which stands in for the memory a benchmark's setup keeps resident
+        std::size_t allocated_byte_count();
+
+        // keeps the optimizer from dropping a computation whose result is otherwise unused
+        template<typename T>
+        inline void do_not_optimize(const T& value)
+        {
+            asm volatile("" : : "r,m"(value) : "memory");
+        }
+
+        class suite
+        {
+        public:
+            // fn performs the measured operation the given number of times
+            using benchmark_fn = std::function<void(std::size_t iterations)>;
+
+            void add(std::string name, benchmark_fn fn);
+
+            // runs every benchmark whose name contains filter and prints nanoseconds, allocations and
+            // allocated bytes per operation
+            void run(std::string_view filter) const;
+        private:
+            struct entry
+            {
+                std::string name;
+                benchmark_fn fn;
+            };
+
+            std::vector<entry> m_entries;
+        };
+
+        void add_lookup_benchmarks(suite& suite);
+        void add_conversion_benchmarks(suite& suite);
+        void add_dispatch_benchmarks(suite& suite);
+        void add_async_reader_benchmarks(suite& suite);
+        void add_startup_benchmarks(suite& suite);
+    }
+}
@@ -0,0 +1,75 @@
+#include "bench_modules.h"
+#include "harness.h"
+#include "patron/services/module_service.h"
+#include "patron/services/static_module_service.h"
+#include <algorithm>
+#include <cctype>
+#include <format>
+#include <memory>
+
+namespace patron
+{
+    namespace bench
+    {
+        namespace
+        {
+            // every command name in the service, lowered when the lookup is case-insensitive so it has to fold
+            template<typename Service>
+            std::vector<std::string> command_names(const Service& service, bool case_sensitive)
+            {
+                std::vector<std::string> names;
+                for (const std::shared_ptr<const module_base>& module : service.modules())
+                {
+                    for (const command_info& cmd : module->commands())
+                    {
+                        std::string& name = names.emplace_back(cmd.name());
+                        if (!case_sensitive)
+                            std::ranges::transform(name, name.begin(), [](unsigned char c) { return std::tolower(c); });
+                    }
+                }
+                return names;
+            }
+
+            template<std::meta::info NS>
+            void add_search_command(suite& suite, std::size_t count, bool case_sensitive)
+            {
+                auto service = std::make_shared<module_service<>>(module_service_config { .case_sensitive_lookup = case_sensitive });
+                service->register_namespace<NS>();
+                auto names = std::make_shared<std::vector<std::string>>(command_names(*service, case_sensitive));
+
+                suite.add(std::format("search_command/{}/{}", count, case_sensitive ? "case_sensitive" : "case_insensitive"),
+                    [service, names](std::size_t iterations) {
+                        for (std::size_t i = 0; i < iterations; ++i)
+                            do_not_optimize(service->search_command((*names)[i % names->size()]).size());
+                    });
+            }
+
+            void add_static_has_command(suite& suite, bool case_sensitive)
+            {
+                using service_type = static_module_service<commands_10::module_0>;
+                auto service = std::make_shared<service_type>(module_service_config { .case_sensitive_lookup = case_sensitive });
+
+                auto names = std::make_shared<std::vector<std::string>>();
+                for (std::size_t i = 0; i < 10; ++i)
+                    names->push_back(std::format(case_sensitive ? "Cmd0_{}" : "cmd0_{}", i));
+
+                suite.add(std::format("static_has_command/10/{}", case_sensitive ? "case_sensitive" : "case_insensitive"),
+                    [service, names](std::size_t iterations) {
+                        for (std::size_t i = 0; i < iterations; ++i)
+                            do_not_optimize(service->has_command((*names)[i % names->size()]));
+                    });
+            }
+        }
+
+        void add_lookup_benchmarks(suite& suite)
+        {
+            for (bool case_sensitive : { true, false })
+            {
+                add_search_command<^^commands_10>(suite, 10, case_sensitive);
+                add_search_command<^^commands_100>(suite, 100, case_sensitive);
+                add_search_command<^^commands_1000>(suite, 1000, case_sensitive);
+                add_static_has_command(suite, case_sensitive);
+            }
+        }
+    }
+}
@@ -0,0 +1,14 @@
+#include "harness.h"
+
+// usage: patron_bench [filter], where only benchmarks whose name contains filter are run
+int main(int argc, char** argv)
+{
+    patron::bench::suite suite;
+    patron::bench::add_lookup_benchmarks(suite);
+    patron::bench::add_conversion_benchmarks(suite);
+    patron::bench::add_dispatch_benchmarks(suite);
+    patron::bench::add_async_reader_benchmarks(suite);
+    patron::bench::add_startup_benchmarks(suite);
+
+    suite.run(argc > 1 ? argv[1] : "");
+}
@@ -0,0 +1,92 @@
+#pragma once
+#include "patron/commands/async_type_reader.h"
+#include "patron/utils/lexical_cast.h"
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+
+namespace patron
+{
+    namespace bench
+    {
+        struct user
+        {
+            std::uint64_t id;
+            std::string name;
+        };
+
+        // an in-memory stand-in for the database an async type reader would ask, counting the round trips made
+        class memory_backend
+        {
+        public:
+            void insert(user user)
+            {
+                std::lock_guard lock(m_mutex);
+                m_users.insert_or_assign(user.id, std::move(user));
+            }
+
+            // one round trip, however many ids are asked for
+            std::vector<std::optional<user>> find_users(std::span<const std::uint64_t> ids) const
+            {
+                std::lock_guard lock(m_mutex);
+                ++m_round_trips;
+
+                std::vector<std::optional<user>> found;
+                found.reserve(ids.size());
+                for (std::uint64_t id : ids)
+                {
+                    auto it = m_users.find(id);
+                    found.push_back(it != m_users.end() ? std::optional(it->second) : std::nullopt);
+                }
+                return found;
+            }
+
+            std::size_t round_trips() const
+            {
+                std::lock_guard lock(m_mutex);
+                return m_round_trips;
+            }
+        private:
+            mutable std::mutex m_mutex;
+            std::unordered_map<std::uint64_t, user> m_users;
+            mutable std::size_t m_round_trips = 0;
+        };
+
+        // reads a user mention, <@id>, or a bare id. the backend and batching are injected as extra data.
+        struct user_reader : async_type_reader<user_reader, user>
+        {
+            memory_backend* backend = nullptr;
+            batch_window batching;
+
+            batch_window window() const override { return batching; }
+
+            void read_many(std::span<const std::string> inputs, async_read_completion<user> completion) override
+            {
+                std::vector<std::uint64_t> ids(inputs.size());
+                std::vector<bool> parsed(inputs.size());
+                for (std::size_t i = 0; i < inputs.size(); ++i)
+                {
+                    std::string_view input = inputs[i];
+                    if (input.starts_with("<@") && input.ends_with('>'))
+                        input = input.substr(2, input.size() - 3);
+
+                    if (std::expected<std::uint64_t, std::errc> id = utility::try_lexical_cast<std::uint64_t>(input))
+                    {
+                        ids[i] = *id;
+                        parsed[i] = true;
+                    }
+                    else
+                        completion.fail(i, type_reader_result::from_error(command_error::parse_failed, "Expected a user mention"));
+                }
+
+                std::vector<std::optional<user>> found = backend->find_users(ids);
+                for (std::size_t i = 0; i < inputs.size(); ++i)
+                    if (parsed[i] && found[i])
+                        completion.add_result(i, std::move(*found[i]));
+                std::move(completion).complete();
+            }
+        };
+    }
+}
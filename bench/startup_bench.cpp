@@ -0,0 +1,51 @@
+#include "bench_modules.h"
+#include "harness.h"
+#include "patron/services/module_service.h"
+#include <format>
+#include <memory>
+#include <string>
+
+namespace patron
+{
+    namespace bench
+    {
+        namespace
+        {
+            // one op is making a service and registering a hundred modules of ten commands each, then running one
+            // command in each of the first dispatched modules, so the lazy runs pay for constructing exactly those
+            void add_register_namespace(suite& suite, bool lazy, std::size_t dispatched)
+            {
+                std::string name = std::format("register_namespace/1000/{}", lazy ? "lazy" : "eager");
+                if (dispatched != 0)
+                    name += std::format("/dispatch_{}_modules", dispatched);
+
+                suite.add(std::move(name), [lazy, dispatched](std::size_t iterations) {
+                    for (std::size_t i = 0; i < iterations; ++i)
+                    {
+                        module_service<> service(module_service_config { .lazy_modules = lazy });
+                        service.register_namespace<^^heavy_commands_1000>();
+                        for (std::size_t m = 0; m < dispatched; ++m)
+                            do_not_optimize(service.run_command(std::format("!Cmd{}_0 42", m)).success());
+                        do_not_optimize(service.modules().size());
+                    }
+                });
+            }
+        }
+
+        void add_startup_benchmarks(suite& suite)
+        {
+            add_register_namespace(suite, false, 0);
+            add_register_namespace(suite, true, 0);
+            add_register_namespace(suite, true, 1);
+            add_register_namespace(suite, true, 100);
+
+            // the steady state once the module exists, which only adds a load of the constructed instance
+            auto service = std::make_shared<module_service<>>(module_service_config { .lazy_modules = true });
+            service->register_namespace<^^commands_1000>();
+            suite.add("run_command/sync/1000/lazy", [service](std::size_t iterations) {
+                for (std::size_t i = 0; i < iterations; ++i)
+                    do_not_optimize(service->run_command("!Cmd57_3 42").success());
+            });
+        }
+    }
+}
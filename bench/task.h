@@ -0,0 +1,107 @@
+#pragma once
+#include "patron/utils/frame_pool.h"
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <utility>
+
+namespace patron
+{
+    namespace bench
+    {
+        struct unpooled_promise {};
+
+        // a minimal lazy task, just enough to drive a coroutine module service from the benchmarks. the pooled
+        // flavour recycles its frames through utility::pooled_promise.
+        template<typename T, bool Pooled>
+        class basic_task
+        {
+        public:
+            struct promise_type : std::conditional_t<Pooled, utility::pooled_promise, unpooled_promise>
+            {
+                std::optional<T> m_value;
+                std::exception_ptr m_exception;
+                std::coroutine_handle<> m_continuation = std::noop_coroutine();
+
+                basic_task get_return_object() { return basic_task(std::coroutine_handle<promise_type>::from_promise(*this)); }
+                std::suspend_always initial_suspend() noexcept { return {}; }
+
+                auto final_suspend() noexcept
+                {
+                    struct awaiter
+                    {
+                        bool await_ready() noexcept { return false; }
+                        std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> handle) noexcept
+                        {
+                            return handle.promise().m_continuation;
+                        }
+                        void await_resume() noexcept {}
+                    };
+                    return awaiter{};
+                }
+
+                template<typename U = T>
+                void return_value(U&& value) { m_value.emplace(std::forward<U>(value)); }
+                void unhandled_exception() { m_exception = std::current_exception(); }
+            };
+
+            basic_task(basic_task&& other) noexcept : m_handle(std::exchange(other.m_handle, {})) {}
+            basic_task& operator=(basic_task&&) = delete;
+
+            ~basic_task()
+            {
+                if (m_handle)
+                    m_handle.destroy();
+            }
+
+            auto operator co_await() && noexcept
+            {
+                struct awaiter
+                {
+                    std::coroutine_handle<promise_type> m_handle;
+
+                    bool await_ready() noexcept { return false; }
+                    std::coroutine_handle<> await_suspend(std::coroutine_handle<> continuation) noexcept
+                    {
+                        m_handle.promise().m_continuation = continuation;
+                        return m_handle;
+                    }
+                    T await_resume() { return take(m_handle); }
+                };
+                return awaiter { m_handle };
+            }
+
+            // runs the task to completion on the calling thread. only valid when nothing it awaits suspends for real,
+            // which holds for every command the benchmarks register.
+            T get() &&
+            {
+                m_handle.resume();
+                return take(m_handle);
+            }
+
+            // runs the task until it first suspends, for when what it waits on is completed from outside
+            void start() { m_handle.resume(); }
+            bool done() const { return m_handle.done(); }
+
+            // the value of a started task that's since finished
+            T result() && { return take(m_handle); }
+        private:
+            std::coroutine_handle<promise_type> m_handle;
+
+            explicit basic_task(std::coroutine_handle<promise_type> handle) : m_handle(handle) {}
+
+            static T take(std::coroutine_handle<promise_type> handle)
+            {
+                if (handle.promise().m_exception)
+                    std::rethrow_exception(handle.promise().m_exception);
+                return std::move(*handle.promise().m_value);
+            }
+        };
+
+        template<typename T = void>
+        using task = basic_task<T, false>;
+
+        template<typename T = void>
+        using pooled_task = basic_task<T, true>;
+    }
+}
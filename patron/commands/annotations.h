@@ -15,6 +15,18 @@ namespace patron
         bool ignore_extra_args = true;
     };
 
+    // on an aggregate, has a parameter of that type read field by field from consecutive arguments rather than
+    // from one, so "!move 3 4" can fill a point { int x; int y; }
+    struct fields {};
+
+    // puts a command under a group, so it's run as "<group> <command>". on a module it groups every command in it,
+    // and a command in a grouped module can have a group of its own under the module's.
+    struct group
+    {
+        utility::static_string_view text;
+        utility::static_span<const char*> aliases;
+    };
+
     struct remarks
     {
         utility::static_string_view text;
@@ -0,0 +1,79 @@
+#include "async_type_reader.h"
+#include "patron/services/executor.h"
+
+namespace patron
+{
+    namespace detail
+    {
+        void async_read_batch::complete(const std::shared_ptr<async_read_batch>& batch)
+        {
+            for (std::size_t i = 0; i < batch->m_waiters.size(); ++i)
+            {
+                const async_read_waiter& waiter = batch->m_waiters[i];
+                *waiter.out = async_read { batch, i };
+                waiter.complete(waiter.context);
+            }
+        }
+
+        void async_type_reader_erased::enqueue(std::string_view input, async_read_waiter waiter, bool last)
+        {
+            const batch_window window = this->window();
+            std::shared_ptr<async_read_batch> full;
+            std::shared_ptr<async_read_batch> opened;
+            {
+                std::lock_guard lock(m_mutex);
+                if (!m_open)
+                {
+                    m_open = make_batch();
+                    if (window.exec)
+                        opened = m_open;
+                }
+
+                m_open->m_inputs.emplace_back(input);
+                m_open->m_waiters.push_back(waiter);
+                // with no executor to send it later, nothing else would
+                if (m_open->m_inputs.size() >= window.max_batch || (!window.exec && last))
+                    full = std::move(m_open);
+            }
+
+            if (full)
+            {
+                // the reads this wakes may hold the last reference to the reader
+                std::shared_ptr<async_type_reader_erased> self = shared_from_this();
+                read_batch(std::move(full));
+            }
+            else if (opened)
+            {
+                window.exec->post([self = shared_from_this(), batch = std::move(opened)] {
+                    self->flush(batch.get());
+                });
+            }
+        }
+
+        void async_type_reader_erased::flush()
+        {
+            std::shared_ptr<async_read_batch> batch;
+            {
+                std::lock_guard lock(m_mutex);
+                batch = std::move(m_open);
+            }
+
+            if (batch)
+            {
+                std::shared_ptr<async_type_reader_erased> self = shared_from_this();
+                read_batch(std::move(batch));
+            }
+        }
+
+        // only sends batch if it's still the open one, it may have filled up and been sent already
+        void async_type_reader_erased::flush(const async_read_batch* batch)
+        {
+            {
+                std::lock_guard lock(m_mutex);
+                if (m_open.get() != batch)
+                    return;
+            }
+            flush();
+        }
+    }
+}
@@ -0,0 +1,248 @@
+#pragma once
+#include "type_reader.h"
+#include <coroutine>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+
+namespace patron
+{
+    class executor;
+
+    template<typename T>
+    class async_read_completion;
+
+    // how an async type reader groups reads into batches. reads are added to the open batch until it holds
+    // max_batch of them, then it's sent. with exec set, opening a batch also posts a job there that sends it, so
+    // whatever was read before exec got to that job shares one round trip. otherwise the batch is sent once the
+    // read that added to it was the last one its caller had, so it only groups the reads of one dispatch: batching
+    // reads from different dispatches needs exec.
+    struct batch_window
+    {
+        std::size_t max_batch = 1;
+        executor* exec = nullptr;
+    };
+
+    namespace detail
+    {
+        class async_read_batch;
+
+        // a finished read: its batch, kept alive for as long as the read is, and its place in it
+        struct async_read
+        {
+            std::shared_ptr<const async_read_batch> batch;
+            std::size_t index = 0;
+
+            const type_reader_result& result() const;
+            // the read's top result, null when it failed
+            const void* value() const;
+        };
+
+        // stores the read into out and calls complete, from whichever thread finished the batch
+        struct async_read_waiter
+        {
+            async_read* out;
+            void (*complete)(void* context);
+            void* context;
+        };
+
+        class async_read_batch
+        {
+        public:
+            virtual ~async_read_batch() = default;
+
+            std::span<const std::string> inputs() const { return m_inputs; }
+            virtual const type_reader_result& result(std::size_t idx) const = 0;
+            virtual const void* value(std::size_t idx) const = 0;
+
+            // hands every read its result and wakes it, once the batch has been read
+            static void complete(const std::shared_ptr<async_read_batch>& batch);
+        private:
+            friend class async_type_reader_erased;
+
+            std::vector<std::string> m_inputs;
+            std::vector<async_read_waiter> m_waiters;
+        };
+
+        inline const type_reader_result& async_read::result() const { return batch->result(index); }
+        inline const void* async_read::value() const { return batch->value(index); }
+
+        // one instance is shared by every thread dispatching on the service, which is what lets reads from
+        // different dispatches end up in the same batch
+        class async_type_reader_erased : public std::enable_shared_from_this<async_type_reader_erased>
+        {
+        public:
+            virtual ~async_type_reader_erased() = default;
+
+            // adds input to the open batch. the waiter can be called before this returns, so the caller mustn't
+            // touch anything it passed in afterwards. last is unset when the caller is about to add more reads, which
+            // is what lets a window without an executor batch them.
+            void enqueue(std::string_view input, async_read_waiter waiter, bool last = true);
+
+            // sends the open batch now rather than waiting for it to fill up
+            void flush();
+
+            virtual batch_window window() const { return {}; }
+        protected:
+            virtual std::shared_ptr<async_read_batch> make_batch() = 0;
+            virtual void read_batch(std::shared_ptr<async_read_batch> batch) = 0;
+        private:
+            std::mutex m_mutex;
+            std::shared_ptr<async_read_batch> m_open;
+
+            void flush(const async_read_batch* batch);
+        };
+
+        template<typename T>
+        class typed_async_read_batch : public async_read_batch
+        {
+        public:
+            const type_reader_result& result(std::size_t idx) const override { return m_entries[idx].result; }
+
+            const void* value(std::size_t idx) const override
+            {
+                const std::vector<type_reader_value<T>>& values = m_entries[idx].values;
+                if (!m_entries[idx].result.success() || values.empty())
+                    return nullptr;
+                return std::addressof(std::ranges::max_element(values, {}, &type_reader_value<T>::weight)->value());
+            }
+        private:
+            friend class async_read_completion<T>;
+
+            struct entry
+            {
+                type_reader_result result;
+                std::vector<type_reader_value<T>> values;
+            };
+
+            std::vector<entry> m_entries;
+        };
+    }
+
+    // what read_many fills in for a batch. a read with nothing added by the time it's completed fails as not
+    // found. if it's never completed, it is when destroyed, so a backend that gives up can't leave reads hanging.
+    template<typename T>
+    class async_read_completion
+    {
+    public:
+        explicit async_read_completion(std::shared_ptr<detail::typed_async_read_batch<T>> batch)
+            : m_batch(std::move(batch))
+        {
+            m_batch->m_entries.resize(m_batch->inputs().size());
+        }
+
+        async_read_completion(async_read_completion&&) noexcept = default;
+        // assigning over a completion would drop its batch without completing it
+        async_read_completion& operator=(async_read_completion&&) = delete;
+
+        ~async_read_completion()
+        {
+            if (m_batch)
+                std::move(*this).complete();
+        }
+
+        std::span<const std::string> inputs() const { return m_batch->inputs(); }
+
+        template<typename U = T> requires std::is_constructible_v<T, U>
+        void add_result(std::size_t idx, U&& value, float weight = 1.0f)
+        {
+            m_batch->m_entries[idx].values.emplace_back(std::forward<U>(value), weight);
+        }
+
+        void fail(std::size_t idx, type_reader_result result)
+        {
+            m_batch->m_entries[idx].result = std::move(result);
+        }
+
+        void complete() &&
+        {
+            for (auto& entry : m_batch->m_entries)
+                if (entry.result.success() && entry.values.empty())
+                    entry.result = type_reader_result::from_error(command_error::object_not_found, "Object not found");
+
+            detail::async_read_batch::complete(std::exchange(m_batch, nullptr));
+        }
+    private:
+        std::shared_ptr<detail::typed_async_read_batch<T>> m_batch;
+    };
+
+    template<typename T>
+    class async_read_result
+    {
+    public:
+        explicit async_read_result(detail::async_read read) : m_read(std::move(read)) {}
+
+        const type_reader_result& result() const { return m_read.result(); }
+        bool has_result() const { return m_read.value() != nullptr; }
+        explicit operator bool() const { return has_result(); }
+
+        const T& top_result() const
+        {
+            if (!has_result())
+                utility::throw_exception(std::logic_error("Tried to get top result from type reader with no results"));
+            return *static_cast<const T*>(m_read.value());
+        }
+    private:
+        detail::async_read m_read;
+    };
+
+    // a type reader backed by something slow to ask, like a database. reads are awaited rather than returned, and
+    // are sent to read_many in batches according to window(). only module_service's coroutine dispatch reads
+    // command arguments with these, every argument before the command starts.
+    template<typename T>
+    class async_type_reader_base : public detail::async_type_reader_erased
+    {
+    public:
+        using value_type = T;
+
+        // reads the whole batch, now or later and on any thread, completing it once it's done. it mustn't throw,
+        // report a failed read through the completion instead.
+        virtual void read_many(std::span<const std::string> inputs, async_read_completion<T> completion) = 0;
+
+        auto read(std::string_view input)
+        {
+            struct awaiter
+            {
+                async_type_reader_base& m_reader;
+                std::string_view m_input;
+                detail::async_read m_read;
+                std::coroutine_handle<> m_handle;
+
+                bool await_ready() const noexcept { return false; }
+                void await_suspend(std::coroutine_handle<> handle)
+                {
+                    m_handle = handle;
+                    m_reader.enqueue(m_input, { &m_read, &resume, this });
+                }
+                async_read_result<T> await_resume() { return async_read_result<T>(std::move(m_read)); }
+
+                static void resume(void* self) { static_cast<awaiter*>(self)->m_handle.resume(); }
+            };
+            return awaiter { *this, input, {}, {} };
+        }
+    protected:
+        std::shared_ptr<detail::async_read_batch> make_batch() override
+        {
+            return std::make_shared<detail::typed_async_read_batch<T>>();
+        }
+
+        void read_batch(std::shared_ptr<detail::async_read_batch> batch) override
+        {
+            auto typed = std::static_pointer_cast<detail::typed_async_read_batch<T>>(std::move(batch));
+            std::span<const std::string> inputs = typed->inputs();
+            read_many(inputs, async_read_completion<T>(std::move(typed)));
+        }
+    };
+
+    template<typename Derived, typename T>
+    struct async_type_reader : async_type_reader_base<T>
+    {
+        static std::shared_ptr<async_type_reader<Derived, T>> create(std::span<const std::any> extra_data)
+        {
+            std::shared_ptr<Derived> result = std::make_shared<Derived>();
+            detail::inject_extra_data(*result, extra_data);
+            return result;
+        }
+    };
+}
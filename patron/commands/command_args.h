@@ -0,0 +1,118 @@
+#pragma once
+#include "command_context.h"
+#include "patron/utils/tokenizer.h"
+#include <optional>
+
+namespace patron
+{
+    class type_reader_result;
+
+    // an argument already read by an async type reader, before the command was started
+    struct prefetched_arg
+    {
+        const void* value;
+        const type_reader_result* result;
+    };
+
+    // a view over the arguments a command was run with. when the arguments come from a tokenized message, the raw
+    // text is kept around so remainder arguments can be sliced out of it instead of being joined back together,
+    // as long as that reads the same as the tokens.
+    class command_args
+    {
+    public:
+        command_args() = default;
+
+        explicit command_args(std::span<const std::string_view> args,
+                              std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+            : m_args(args), m_resource(resource) {}
+
+        command_args(std::span<const std::string_view> args, std::string_view source, std::span<const std::size_t> offsets,
+                     std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+            : m_args(args), m_offsets(offsets), m_source(source), m_resource(resource) {}
+
+        // the arguments of a tokenized message, skipping the first skip tokens (typically the command name)
+        command_args(const utility::tokenizer& tokenizer, std::size_t skip)
+            : command_args(tokenizer.tokens().subspan(skip), tokenizer.source(), tokenizer.offsets().subspan(skip),
+                           tokenizer.resource()) {}
+
+        std::size_t size() const { return m_args.size(); }
+        bool empty() const { return m_args.empty(); }
+        std::string_view operator[](std::size_t idx) const { return m_args[idx]; }
+        std::span<const std::string_view> values() const { return m_args; }
+
+        // the text from argument idx to the end, if the arguments were tokenized from a single message and none of
+        // them from idx on was quoted or escaped. those only have their unescaped text in the tokens, which have to
+        // be joined instead, so a remainder never sees quotes or backslashes the other arguments don't.
+        std::optional<std::string_view> remainder(std::size_t idx) const
+        {
+            if (m_offsets.empty())
+                return std::nullopt;
+
+            // a token is the source itself exactly when there was nothing to strip from it
+            for (std::size_t i = idx; i < m_args.size(); ++i)
+                if (m_args[i].data() != m_source.data() + m_offsets[i])
+                    return std::nullopt;
+            return m_source.substr(m_offsets[idx]);
+        }
+
+        // the same arguments without the first count, like the group and command names routing took up
+        command_args drop_front(std::size_t count) const
+        {
+            command_args result = *this;
+            result.m_args = m_args.subspan(count);
+            if (!m_offsets.empty())
+                result.m_offsets = m_offsets.subspan(count);
+            if (!m_prefetched.empty())
+                result.m_prefetched = m_prefetched.subspan(count);
+            return result;
+        }
+
+        // where temporaries made while running the command should be allocated, usually the dispatch's arena
+        std::pmr::memory_resource* resource() const { return m_resource; }
+
+        // what argument idx was read into ahead of time, null if it wasn't
+        const prefetched_arg* prefetched(std::size_t idx) const
+        {
+            if (idx >= m_prefetched.size() || !m_prefetched[idx].result)
+                return nullptr;
+            return &m_prefetched[idx];
+        }
+
+        // whether any argument from idx on was read ahead of time
+        bool prefetched_from(std::size_t idx) const
+        {
+            for (std::size_t i = idx; i < m_prefetched.size(); ++i)
+                if (m_prefetched[i].result)
+                    return true;
+            return false;
+        }
+
+        // the same arguments, along with what was prefetched for them, one entry per argument
+        command_args with_prefetched(std::span<const prefetched_arg> prefetched) const
+        {
+            command_args result = *this;
+            result.m_prefetched = prefetched;
+            return result;
+        }
+
+        // who the command is being run for, an empty context unless the caller gave one
+        const command_context& context() const { return *m_context; }
+
+        // the same arguments run for context, which has to outlive them
+        command_args with_context(const command_context& context) const
+        {
+            command_args result = *this;
+            result.m_context = &context;
+            return result;
+        }
+    private:
+        static constexpr command_context empty_context {};
+
+        std::span<const std::string_view> m_args;
+        std::span<const prefetched_arg> m_prefetched;
+        std::span<const std::size_t> m_offsets;
+        std::string_view m_source;
+        std::pmr::memory_resource* m_resource = std::pmr::get_default_resource();
+        const command_context* m_context = &empty_context;
+    };
+}
@@ -0,0 +1,14 @@
+#pragma once
+#include <cstdint>
+
+namespace patron
+{
+    // who a command is being run for, for its preconditions to check. user is whatever id the caller keys its
+    // users by, cooldowns are tracked per user. data is anything else the caller's own preconditions know how to
+    // cast back.
+    struct command_context
+    {
+        std::uint64_t user = 0;
+        const void* data = nullptr;
+    };
+}
@@ -1,103 +1,689 @@
 #pragma once
+#include "annotations.h"
 #include "command_function.h"
+#include "preconditions.h"
 #include "patron/services/module_service_base.h"
-#include "patron/utils/join.h"
+#include "patron/utils/enum_parser.h"
+#include "patron/utils/integer_list.h"
 #include "patron/utils/reflection.h"
+#include "patron/utils/throw.h"
+#include <algorithm>
+#include <array>
+#include <memory>
+#include <span>
+#include <tuple>
+#include <vector>
 
 namespace patron
 {
+    namespace detail
+    {
+        // what a parameter is read as, an optional one as what it holds
+        template<typename T>
+        struct read_type { using type = T; };
+
+        template<typename T>
+        struct read_type<std::optional<T>> { using type = T; };
+
+        template<typename T>
+        using read_type_t = typename read_type<T>::type;
+
+        // one per cooldown annotation, its address keys the annotation's buckets
+        template<std::meta::info Annotation>
+        inline constexpr char cooldown_key {};
+    }
+
     class command_execution
     {
     public:
-        template<std::meta::info FnInfo, utility::static_span<const std::meta::info> Params, typename Module>
-        static command_function create_command_function(std::string_view cmd, bool ignore_extra_args, bool remainder)
+        template<std::meta::info FnInfo, utility::static_span<const std::meta::info> Params, typename Module, typename ResultType>
+        static command_function create_command_function()
         {
             using Result = typename[:std::meta::return_type_of(FnInfo):];
-            using Function = std::function<Result(Module*, std::span<const std::string>, module_service_base*)>;
+            static_assert(std::same_as<Result, ResultType>, "Command return type does not match the service's result type");
+            static_assert(!utility::is_awaitable<Result> || std::ranges::none_of(Params, [](std::meta::info p) {
+                return std::meta::is_reference_type(std::meta::type_of(p));
+            }), "Coroutine commands have to take their parameters by value, see invoke_fn");
+            constexpr command cmd = std::meta::extract<command>(utility::find_annotation(FnInfo, ^^command).value());
+
+            // async preconditions give back the same task as commands, of a precondition_result
+            using PreconditionTask = decltype([] {
+                if constexpr (utility::is_awaitable<ResultType>)
+                    return std::type_identity<typename[:std::meta::substitute(std::meta::template_of(^^ResultType), { ^^precondition_result }):]>();
+                else
+                    return std::type_identity<void>();
+            }())::type;
+            static_assert(utility::is_awaitable<ResultType> || async_precondition_count<FnInfo, Module>() == 0,
+                          "Async preconditions need a module service in coroutine mode");
+
+            command_function::async_precondition_fn<PreconditionTask> async_preconditions = nullptr;
+            if constexpr (async_precondition_count<FnInfo, Module>() != 0)
+                async_preconditions = &check_async_precondition<FnInfo, Module, PreconditionTask>;
+
+            return command_function(+[](module_base* module, const command_args& args, module_service_base* service) {
+                return invoke_command<FnInfo, Params>(static_cast<Module*>(module), args, service);
+            }, target_arg_count(Params), reader_slots<Params, cmd.remainder>,
+               has_sync_preconditions<FnInfo, Module>() ? &check_static_preconditions<FnInfo, Module> : nullptr,
+               has_sync_preconditions<FnInfo, Module>() ? &acquire_cooldowns<FnInfo, Module> : nullptr, async_preconditions, async_precondition_count<FnInfo, Module>(), &score_overload<Params, cmd.remainder>);
+        }
 
+        // runs the command's static preconditions, then its dynamic ones, the module's before the command's own in
+        // both cases, and gives back the result to report for the first that isn't met
+        template<std::meta::info FnInfo, typename Module>
+        static std::optional<command_result> check_preconditions(const command_context& context, module_service_base* service)
+        {
+            if (std::optional<command_result> unmet = check_static_preconditions<FnInfo, Module>(context, service))
+                return unmet;
+            return acquire_cooldowns<FnInfo, Module>(context, service);
+        }
+
+        // the static preconditions only look at the context, so checking them has no effect on later dispatches
+        template<std::meta::info FnInfo, typename Module>
+        static std::optional<command_result> check_static_preconditions(const command_context& context, module_service_base*)
+        {
+            template for (constexpr std::meta::info annotation : precondition_annotations<FnInfo, Module>)
+            {
+                using A = std::remove_cv_t<typename[:std::meta::type_of(annotation):]>;
+                if constexpr (static_precondition<A>)
+                {
+                    constexpr A precondition = std::meta::extract<A>(annotation);
+                    if (precondition_result result = precondition.check(context); !result.success())
+                        return command_result::from_error(command_error::unmet_precondition, result.message_storage());
+                }
+            }
+
+            return std::nullopt;
+        }
+
+        // takes a use of each of the command's cooldowns, so it's only run for the command that's about to run
+        template<std::meta::info FnInfo, typename Module>
+        static std::optional<command_result> acquire_cooldowns(const command_context& context, module_service_base* service)
+        {
+            template for (constexpr std::meta::info annotation : precondition_annotations<FnInfo, Module>)
+            {
+                using A = std::remove_cv_t<typename[:std::meta::type_of(annotation):]>;
+                if constexpr (std::same_as<A, cooldown>)
+                {
+                    constexpr cooldown limit = std::meta::extract<cooldown>(annotation);
+                    if (!service->cooldowns().try_acquire(&detail::cooldown_key<annotation>, limit.per_user ? context.user : 0,
+                                                          limit.uses, std::chrono::milliseconds(limit.period_ms)))
+                        return command_result::from_error(command_error::unmet_precondition, "Command is on cooldown");
+                }
+            }
+
+            return std::nullopt;
+        }
+
+        template<std::meta::info FnInfo, typename Module>
+        static consteval bool has_sync_preconditions()
+        {
+            bool any = false;
+            template for (constexpr std::meta::info annotation : precondition_annotations<FnInfo, Module>)
+            {
+                using A = std::remove_cv_t<typename[:std::meta::type_of(annotation):]>;
+                any = any || static_precondition<A> || std::same_as<A, cooldown>;
+            }
+            return any;
+        }
+
+        template<std::meta::info FnInfo, typename Module>
+        static consteval std::size_t async_precondition_count()
+        {
+            std::size_t count = 0;
+            template for (constexpr std::meta::info annotation : precondition_annotations<FnInfo, Module>)
+            {
+                using A = std::remove_cv_t<typename[:std::meta::type_of(annotation):]>;
+                count += async_precondition<A>;
+            }
+            return count;
+        }
+
+        // converts the arguments in order, stopping at the first one that fails, then calls the command with them.
+        // a failed conversion is returned as an error result unless the service is configured to throw. arguments
+        // read by async type readers were all read together beforehand, only their results are taken here.
+        template<std::meta::info FnInfo, utility::static_span<const std::meta::info> Params, typename Module>
+        static auto invoke_command(Module* module, const command_args& args, module_service_base* service)
+            -> expected_result<typename[:std::meta::return_type_of(FnInfo):]>
+        {
+            using Result = typename[:std::meta::return_type_of(FnInfo):];
+            constexpr command cmd = std::meta::extract<command>(utility::find_annotation(FnInfo, ^^command).value());
             constexpr std::size_t argc = target_arg_count(Params);
-            return command_function(Function([=](Module* module, std::span<const std::string> args, module_service_base* service) {
-                return [=]<std::size_t... Is>(std::index_sequence<Is...>) {
-                    return invoke_fn<Result>(std::mem_fn(&[:FnInfo:]), module,
-                        convert_arg_at<Params, Is>(cmd, ignore_extra_args, remainder, argc, args, service)...);
-                }(std::make_index_sequence<Params.size>());
-            }), argc);
+            static_assert(std::ranges::none_of(Params.begin(), Params.end() - (Params.size != 0), [](std::meta::info p) {
+                return is_list_type(std::meta::type_of(p));
+            }), "Only the last parameter can be a list");
+            static_assert(!cmd.remainder || Params.size == 0 || !is_list_type(std::meta::type_of(Params[Params.size - 1])) ||
+                          is_integer_vector(std::meta::type_of(Params[Params.size - 1])),
+                          "A remainder parameter can only be a list when it's a vector of integers");
+            static_assert(std::ranges::none_of(Params, [](std::meta::info p) {
+                std::meta::info t = std::meta::remove_cvref(std::meta::type_of(p));
+                if (!std::meta::has_template_arguments(t) || std::meta::template_of(t) != ^^std::optional)
+                    return false;
+                std::meta::info held = std::meta::template_arguments_of(t)[0];
+                return is_list_type(held) || is_field_type(held);
+            }), "Lists and fields can't be optional");
+            return [&]<std::size_t... Is>(std::index_sequence<Is...>) -> expected_result<Result> {
+                std::tuple<std::optional<arg_type<Params, Is>>...> converted;
+                std::optional<command_result> error;
+
+                auto convert = [&]<std::size_t I>(std::integral_constant<std::size_t, I>) {
+                    expected_result<arg_type<Params, I>> value =
+                        convert_arg_at<Params, I>(cmd.text, cmd.ignore_extra_args, cmd.remainder, argc, args, service);
+                    if (!value)
+                    {
+                        error = std::move(value.error());
+                        return false;
+                    }
+
+                    std::get<I>(converted).emplace(std::move(*value));
+                    return true;
+                };
+
+                if (!(convert(std::integral_constant<std::size_t, Is>{}) && ...))
+                    return std::unexpected(std::move(*error));
+
+                return invoke_fn<Result>(std::mem_fn(&[:FnInfo:]), module, std::move(*std::get<Is>(converted))...);
+            }(std::make_index_sequence<Params.size>());
+        }
+
+        static consteval std::string build_usage(std::meta::info command)
+        {
+            std::string result;
+            for (std::meta::info p : std::meta::parameters_of(command))
+            {
+                const bool optional = std::meta::has_default_argument(p);
+                result += optional ? '<' : '[';
+                result += std::meta::identifier_of(p);
+                if (is_list_type(std::meta::type_of(p)))
+                    result += "...";
+                result += optional ? '>' : ']';
+                result += ' ';
+            }
+
+            if (!result.empty())
+                result.pop_back();
+
+            return result;
+        }
+
+        // converts each argument the command takes through cache, as what its reader slot says, and adds up the
+        // weight of each one's top result, lexical casts counting as 1. arguments past the end, empty optional ones,
+        // the remainder, lists and fields are left to the usual conversion, and so are types with an async type
+        // reader, whose reads only start once the overload is picked.
+        template<utility::static_span<const std::meta::info> Params, bool Remainder>
+        static std::optional<float> score_overload(const command_args& args, detail::conversion_cache& cache,
+                                                   module_service_base* service)
+        {
+            return [&]<std::size_t... Is>(std::index_sequence<Is...>) -> std::optional<float> {
+                float score = 0.0f;
+                auto add = [&]<std::size_t I>(std::integral_constant<std::size_t, I>) {
+                    using ArgType = arg_type<Params, I>;
+                    constexpr std::size_t at = arg_offset(Params, I);
+                    if constexpr ((Remainder && I == Params.size - 1) || is_list_type(^^ArgType) || is_field_type(^^ArgType))
+                        return true;
+                    else
+                    {
+                        if (at >= args.size() || (utility::specialization_of<ArgType, std::optional> && args[at].empty()))
+                            return true;
+
+                        using T = detail::read_type_t<ArgType>;
+                        const std::size_t slot = detail::type_reader_slot<T>();
+                        const detail::conversion_cache::conversion* conversion = cache.find(slot, at);
+                        if (!conversion)
+                        {
+                            if (service->get_async_type_reader<T>())
+                                return true;
+                            conversion = &convert_cached<T>(args[at], slot, at, cache, service);
+                        }
+
+                        score += conversion->weight;
+                        return conversion->value != nullptr;
+                    }
+                };
+
+                if (!(add(std::integral_constant<std::size_t, Is>{}) && ...))
+                    return std::nullopt;
+                return score;
+            }(std::make_index_sequence<Params.size>());
+        }
+
+        // how many arguments the command can't do without, each field of a fields parameter counting as one
+        static consteval std::size_t target_arg_count(utility::static_span<const std::meta::info> params)
+        {
+            std::size_t count = 0;
+            for (std::meta::info p : params)
+            {
+                std::meta::info t = std::meta::type_of(p);
+                if ((!std::meta::has_template_arguments(t) || std::meta::template_of(t) != ^^std::optional) &&
+                    !std::meta::has_default_argument(p))
+                    count += arg_width(t);
+            }
+            return count;
+        }
+
+        // a std::vector or std::span parameter takes every argument left, one element per argument
+        static consteval bool is_list_type(std::meta::info type)
+        {
+            type = std::meta::remove_cvref(type);
+            return std::meta::has_template_arguments(type) &&
+                   (std::meta::template_of(type) == ^^std::vector || std::meta::template_of(type) == ^^std::span);
+        }
+
+        // the one list a remainder parameter can be, read from the remaining text split by the separator
+        static consteval bool is_integer_vector(std::meta::info type)
+        {
+            type = std::meta::remove_cvref(type);
+            if (!std::meta::has_template_arguments(type) || std::meta::template_of(type) != ^^std::vector)
+                return false;
+
+            const std::meta::info element = std::meta::remove_cv(std::meta::template_arguments_of(type)[0]);
+            return std::meta::is_integral_type(element) && element != ^^bool && element != ^^char;
+        }
+
+        static consteval bool is_field_type(std::meta::info type)
+        {
+            type = std::meta::remove_cvref(type);
+            return std::meta::is_class_type(type) && std::meta::is_aggregate_type(type) &&
+                   utility::find_annotation(type, ^^fields).has_value();
+        }
+
+        // how many arguments a parameter of type reads, none for a list since it has no fixed count
+        static consteval std::size_t arg_width(std::meta::info type)
+        {
+            if (is_list_type(type))
+                return 0;
+            if (!is_field_type(type))
+                return 1;
+
+            std::size_t width = 0;
+            for (std::meta::info member : std::meta::nonstatic_data_members_of(std::meta::remove_cvref(type),
+                                                                               std::meta::access_context::unchecked()))
+                width += arg_width(std::meta::type_of(member));
+            return width;
+        }
+
+        // where parameter idx's arguments start
+        static consteval std::size_t arg_offset(utility::static_span<const std::meta::info> params, std::size_t idx)
+        {
+            std::size_t offset = 0;
+            for (std::size_t i = 0; i < idx; ++i)
+                offset += arg_width(std::meta::type_of(params[i]));
+            return offset;
         }
     private:
+        template<typename E>
+        static std::unexpected<command_result> fail(module_service_base* service, E&& e)
+        {
+            if (service->config().throw_exceptions)
+                utility::throw_exception(std::forward<E>(e));
+            return std::unexpected(command_result::from_error(std::forward<E>(e)));
+        }
+
+        // what a type without a type reader is read with: enums by the names of their enumerators, following the
+        // service's case sensitivity, and everything else with a lexical cast when there is one
         template<typename T>
-        static T convert_arg(const std::string& arg, std::size_t index, std::string_view cmd, module_service_base* service)
+        static std::optional<T> convert_builtin(std::string_view arg, module_service_base* service)
         {
-            try
+            if constexpr (std::is_enum_v<T>)
+                return utility::parse_enum<T>(arg, service->config().case_sensitive_lookup);
+            else if constexpr (requires { utility::try_lexical_cast<T>(std::declval<std::string_view>()); })
             {
-                if constexpr (utility::specialization_of<T, std::optional>)
+                if (std::expected<T, std::errc> value = utility::try_lexical_cast<T>(arg))
+                    return std::move(*value);
+                return std::nullopt;
+            }
+            else
+                return std::nullopt;
+        }
+
+        template<typename T>
+        static expected_result<T> convert_arg(std::string_view arg, std::size_t index, std::string_view cmd,
+                                              module_service_base* service)
+        {
+            if constexpr (utility::specialization_of<T, std::optional>)
+            {
+                if (arg.empty())
+                    return T(std::nullopt);
+                return convert_arg<typename T::value_type>(arg, index, cmd, service).transform([](auto&& value) {
+                    return T(std::forward<decltype(value)>(value));
+                });
+            }
+            else
+            {
+                if (type_reader_base<T>* reader = service->get_type_reader<T>())
                 {
-                    if (arg.empty())
-                        return std::nullopt;
-                    return convert_arg<typename T::value_type>(arg, index, cmd, service);
+                    if (type_reader_result result = reader->read(arg); result.success())
+                        return reader->top_result();
+                    else
+                    {
+                        return fail(service, bad_command_argument(result.error().value(), arg, index + 1, cmd, result.message_storage()));
+                    }
                 }
-                else
+
+                if (std::optional<T> value = convert_builtin<T>(arg, service))
+                    return std::move(*value);
+
+                return fail(service, bad_command_argument(arg, index + 1, cmd, typeid(T)));
+            }
+        }
+
+        // the same conversion convert_arg makes, kept in cache instead of returned
+        template<typename T>
+        static const detail::conversion_cache::conversion& convert_cached(std::string_view arg, std::size_t slot, std::size_t index,
+                                                                          detail::conversion_cache& cache, module_service_base* service)
+        {
+            if (type_reader_base<T>* reader = service->get_type_reader<T>())
+            {
+                if (!reader->read(arg).success() || !reader->has_result())
+                    return cache.add_failure(slot, index);
+
+                const type_reader_value<T>& top = *std::ranges::max_element(reader->results(), {}, &type_reader_value<T>::weight);
+                return cache.add(slot, index, top.value(), top.weight());
+            }
+
+            if (std::optional<T> value = convert_builtin<T>(arg, service))
+                return cache.add(slot, index, std::move(*value), 1.0f);
+
+            return cache.add_failure(slot, index);
+        }
+
+        template<utility::static_span<const std::meta::info> Params, std::size_t I>
+        using arg_type = std::remove_cvref_t<typename[:std::meta::type_of(Params[I]):]>;
+
+        // every annotation of the module then of the command, the preconditions among them are picked out by type
+        template<std::meta::info FnInfo, typename Module>
+        static constexpr std::span<const std::meta::info> precondition_annotations = define_static_array([] consteval {
+            std::vector<std::meta::info> out = std::meta::annotations_of(^^Module);
+            for (std::meta::info annotation : std::meta::annotations_of(FnInfo))
+                out.push_back(annotation);
+            return out;
+        }());
+
+        template<std::meta::info FnInfo, typename Module, typename Task>
+        static Task check_async_precondition(std::size_t idx, const command_context& context)
+        {
+            std::size_t i = 0;
+            template for (constexpr std::meta::info annotation : precondition_annotations<FnInfo, Module>)
+            {
+                using A = std::remove_cv_t<typename[:std::meta::type_of(annotation):]>;
+                if constexpr (async_precondition<A>)
                 {
-                    if (std::unique_ptr<type_reader_base<T>> reader = service->create_type_reader<T>())
+                    static_assert(std::same_as<decltype(std::declval<const A&>().check(context)), Task>,
+                                  "Async precondition return type does not match the service's task type");
+                    if (i++ == idx)
                     {
-                        if (type_reader_result result = reader->read(arg); result.success())
-                            return reader->top_result();
-                        else
-                            throw bad_command_argument(result.error().value(), arg, index + 1, cmd, result.message());
+                        constexpr A precondition = std::meta::extract<A>(annotation);
+                        return precondition.check(context);
                     }
+                }
+            }
+            std::unreachable();
+        }
 
-                    if constexpr (requires { utility::lexical_cast<T>(std::declval<std::string>()); })
-                        return utility::lexical_cast<T>(arg);
+        // the parameter that reads argument idx on its own, or none when it's a field
+        static consteval std::optional<std::size_t> param_at(utility::static_span<const std::meta::info> params, std::size_t idx)
+        {
+            for (std::size_t i = 0, offset = 0; i < params.size; offset += arg_width(std::meta::type_of(params[i])), ++i)
+            {
+                const std::size_t width = arg_width(std::meta::type_of(params[i]));
+                if (idx >= offset && idx < offset + width)
+                    return is_field_type(std::meta::type_of(params[i])) ? std::nullopt : std::optional<std::size_t>(i);
+            }
+            return std::nullopt;
+        }
+
+        template<utility::static_span<const std::meta::info> Params, bool Remainder, std::size_t Idx>
+        static consteval command_function::reader_slot_fn reader_slot()
+        {
+            constexpr std::optional<std::size_t> param = param_at(Params, Idx);
+            if constexpr (!param || (Remainder && *param == Params.size - 1))
+                return nullptr;
+            else
+                return &detail::type_reader_slot<detail::read_type_t<arg_type<Params, *param>>>;
+        }
+
+        // one per argument before any list, a remainder parameter is read from the joined text and fields one by
+        // one, so they're left out of prefetching
+        template<utility::static_span<const std::meta::info> Params, bool Remainder>
+        static constexpr auto reader_slots = []<std::size_t... Is>(std::index_sequence<Is...>) {
+            return std::array<command_function::reader_slot_fn, sizeof...(Is)> { reader_slot<Params, Remainder, Is>()... };
+        }(std::make_index_sequence<arg_offset(Params, Params.size)>());
+
+        // an argument an async type reader has already read, all that's left is to take its result
+        template<typename T>
+        static expected_result<T> convert_prefetched(const prefetched_arg& read, std::string_view arg, std::size_t index,
+                                                     std::string_view cmd, module_service_base* service)
+        {
+            if (!read.value)
+            {
+                return fail(service, bad_command_argument(read.result->error().value(), arg, index + 1, cmd,
+                                                          read.result->message_storage()));
+            }
+            return T(*static_cast<const detail::read_type_t<T>*>(read.value));
+        }
+
+        template<utility::static_span<const std::meta::info> Params, std::size_t I>
+        static expected_result<arg_type<Params, I>> convert_arg_at(
+            std::string_view cmd, bool ignore_extra_args, bool remainder, std::size_t argc,
+            const command_args& args, module_service_base* service)
+        {
+            using ArgType = arg_type<Params, I>;
+            constexpr std::size_t at = arg_offset(Params, I);
+            if constexpr (is_integer_vector(^^ArgType))
+            {
+                if (remainder)
+                    return convert_remainder_list<ArgType>(args, at, cmd, service);
+                return convert_list<ArgType>(args, at, cmd, service);
+            }
+            else if constexpr (is_list_type(^^ArgType))
+                return convert_list<ArgType>(args, at, cmd, service);
+            else
+            {
+                if (at >= args.size())
+                {
+                    if (ignore_extra_args)
+                        return ArgType{};
                     else
-                        throw utility::bad_lexical_cast("std::string", typeid(T).name());
+                        return fail(service, bad_argument_count(cmd, args.size(), argc));
                 }
+
+                if (remainder && I == Params.size - 1)
+                {
+                    if (std::optional<std::string_view> rest = args.remainder(at))
+                        return convert_arg<ArgType>(*rest, at, cmd, service);
+
+                    // kept in the dispatch's arena like a list span's elements, a string view parameter is given it
+                    const char separator = service->config().separator_char;
+                    std::size_t size = args.size() - at - 1;
+                    for (std::size_t i = at; i < args.size(); ++i)
+                        size += args[i].size();
+
+                    char* joined = std::pmr::polymorphic_allocator<char>(args.resource()).allocate(size);
+                    char* out = joined;
+                    for (std::size_t i = at; i < args.size(); ++i)
+                    {
+                        if (i != at)
+                            *out++ = separator;
+                        out = std::ranges::copy(args[i], out).out;
+                    }
+
+                    return convert_arg<ArgType>(std::string_view(joined, size), at, cmd, service);
+                }
+
+                return convert_at<ArgType>(args, at, cmd, argc, service);
             }
-            catch (const utility::bad_lexical_cast& e)
+        }
+
+        // a parameter or field read from the arguments starting at at
+        template<typename T>
+        static expected_result<T> convert_at(const command_args& args, std::size_t at, std::string_view cmd, std::size_t argc,
+                                             module_service_base* service)
+        {
+            if constexpr (is_field_type(^^T))
+                return convert_fields<T>(args, at, cmd, argc, service);
+            else
             {
-                throw bad_command_argument(command_error::parse_failed, arg, index + 1, cmd, e.what());
+                if (const prefetched_arg* read = args.prefetched(at))
+                    return convert_prefetched<T>(*read, args[at], at, cmd, service);
+                return convert_arg<T>(args[at], at, cmd, service);
             }
         }
 
-        template<utility::static_span<const std::meta::info> Params, std::size_t I>
-        static auto convert_arg_at(std::string_view cmd, bool ignore_extra_args, bool remainder, std::size_t argc,
-                                   std::span<const std::string> args, module_service_base* service)
+        // each field in declaration order from its own argument, or arguments when it's a fields type too
+        template<typename T>
+        static expected_result<T> convert_fields(const command_args& args, std::size_t at, std::string_view cmd,
+                                                 std::size_t argc, module_service_base* service)
         {
-            using ArgType = [:std::meta::type_of(Params[I]):];
-            if (I >= args.size())
+            T value{};
+            std::optional<command_result> error;
+            std::size_t idx = at;
+
+            constexpr std::meta::access_context ctx = std::meta::access_context::unchecked();
+            template for (constexpr std::meta::info member : define_static_array(std::meta::nonstatic_data_members_of(^^T, ctx)))
             {
-                if (ignore_extra_args)
-                    return ArgType{};
-                else
-                    throw bad_argument_count(cmd, args.size(), argc);
+                using Field = std::remove_cvref_t<typename[:std::meta::type_of(member):]>;
+                static_assert(!is_list_type(^^Field) && !utility::specialization_of<Field, std::optional>,
+                              "Fields can't be lists or optional");
+
+                if (!error)
+                {
+                    if (idx >= args.size())
+                        error = fail(service, bad_argument_count(cmd, args.size(), argc)).error();
+                    else if (expected_result<Field> field = convert_at<Field>(args, idx, cmd, argc, service))
+                    {
+                        value.[:member:] = std::move(*field);
+                        idx += arg_width(^^Field);
+                    }
+                    else
+                        error = std::move(field.error());
+                }
             }
 
-            if (remainder && I == Params.size - 1)
-                return convert_arg<ArgType>(utility::join(args.subspan(I), ' '), I, cmd, service);
+            if (error)
+                return std::unexpected(std::move(*error));
+            return value;
+        }
+
+        // integers nothing reads differently, no type reader and none of the list's own arguments prefetched, are
+        // parsed as a whole list at once, so a list of a hundred ids costs little more than copying it
+        template<typename Element>
+        static bool bulk_integers(const command_args& args, std::size_t at, module_service_base* service)
+        {
+            if constexpr (utility::list_integer<Element>)
+                return !args.prefetched_from(at) && !service->get_type_reader<Element>();
             else
-                return convert_arg<ArgType>(args[I], I, cmd, service);
+                return false;
         }
 
-        template<typename Result>
-        static Result invoke_fn(auto&& fn, auto&&... args)
+        // the same error the element's convert_arg gives
+        template<typename Element>
+        static std::unexpected<command_result> fail_list(const command_args& args, std::size_t index, std::string_view cmd,
+                                                         module_service_base* service)
         {
-            return std::invoke(std::forward<decltype(fn)>(fn), std::forward<decltype(args)>(args)...);
+            return fail(service, bad_command_argument(args[index], index + 1, cmd, typeid(Element)));
         }
 
-        template<typename Result> requires utility::is_awaitable<Result>
-        static Result invoke_fn(auto&& fn, auto&&... args)
+        // every argument from at on, one element each. a span's elements are kept in the dispatch's arena, so it's
+        // only valid while the command runs, and a span of string views is the arguments themselves.
+        template<typename T>
+        static expected_result<T> convert_list(const command_args& args, std::size_t at, std::string_view cmd,
+                                               module_service_base* service)
         {
-            if constexpr (std::is_void_v<utility::await_result_t<Result>>)
-                co_await std::invoke(std::forward<decltype(fn)>(fn), std::forward<decltype(args)>(args)...);
+            using Element = std::remove_cv_t<typename T::value_type>;
+            static_assert(arg_width(^^Element) == 1, "List elements have to be read from one argument each");
+
+            const std::span<const std::string_view> tokens = args.values().subspan(std::min(at, args.size()));
+            const std::size_t count = tokens.size();
+            const bool bulk = bulk_integers<Element>(args, at, service);
+            if constexpr (utility::specialization_of<T, std::vector>)
+            {
+                T values;
+                if constexpr (utility::list_integer<Element>)
+                {
+                    if (bulk)
+                    {
+                        if (auto parsed = utility::parse_integers(tokens, values); !parsed)
+                            return fail_list<Element>(args, at + parsed.error().index, cmd, service);
+                        return values;
+                    }
+                }
+
+                values.reserve(count);
+                for (std::size_t i = at; i < at + count; ++i)
+                {
+                    expected_result<Element> value = convert_at<Element>(args, i, cmd, 0, service);
+                    if (!value)
+                        return std::unexpected(std::move(value.error()));
+                    values.push_back(std::move(*value));
+                }
+                return values;
+            }
             else
-                co_return co_await std::invoke(std::forward<decltype(fn)>(fn), std::forward<decltype(args)>(args)...);
+            {
+                static_assert(std::is_const_v<typename T::element_type> && T::extent == std::dynamic_extent,
+                              "A list span has to be a dynamic span of const elements");
+
+                if constexpr (std::same_as<Element, std::string_view>)
+                    return T(tokens);
+                else
+                {
+                    static_assert(std::is_trivially_destructible_v<Element>,
+                                  "A list span's elements are never destroyed, use a vector for these");
+
+                    std::pmr::polymorphic_allocator<Element> allocator(args.resource());
+                    Element* elements = allocator.allocate(count);
+                    if constexpr (utility::list_integer<Element>)
+                    {
+                        if (bulk)
+                        {
+                            if (auto parsed = utility::parse_integers(tokens, elements); !parsed)
+                            {
+                                allocator.deallocate(elements, count);
+                                return fail_list<Element>(args, at + parsed.error().index, cmd, service);
+                            }
+                            return T(elements, count);
+                        }
+                    }
+
+                    for (std::size_t i = 0; i < count; ++i)
+                    {
+                        expected_result<Element> value = convert_at<Element>(args, at + i, cmd, 0, service);
+                        if (!value)
+                        {
+                            allocator.deallocate(elements, count);
+                            return std::unexpected(std::move(value.error()));
+                        }
+                        std::construct_at(elements + i, std::move(*value));
+                    }
+                    return T(elements, count);
+                }
+            }
         }
 
-        static consteval std::size_t target_arg_count(utility::static_span<const std::meta::info> params)
+        // a remainder list of integers is parsed straight from the remaining text, split by the separator the same
+        // way the tokenizer splits it, so an item's index is its argument's. when there's no text to slice or the
+        // items can't be parsed in bulk, it's read like any other list.
+        template<typename T>
+        static expected_result<T> convert_remainder_list(const command_args& args, std::size_t at, std::string_view cmd,
+                                                         module_service_base* service)
         {
-            return std::ranges::count_if(params, [](std::meta::info p) {
-                std::meta::info t = std::meta::type_of(p);
-                return (!std::meta::has_template_arguments(t) || std::meta::template_of(t) != ^^std::optional) &&
-                       !std::meta::has_default_argument(p);
-            });
+            using Element = typename T::value_type;
+            const std::optional<std::string_view> rest = at < args.size() ? args.remainder(at) : std::nullopt;
+            if (!rest || !bulk_integers<Element>(args, at, service))
+                return convert_list<T>(args, at, cmd, service);
+
+            T values;
+            if (auto parsed = utility::parse_integer_list(*rest, service->config().separator_char, values); !parsed)
+                return fail_list<Element>(args, at + parsed.error().index, cmd, service);
+            return values;
+        }
+
+        // a coroutine command is called here too and its task handed back as is, so it has to take its parameters by
+        // value: the converted arguments are gone by the time it resumes. wrapping it in another coroutine to keep
+        // them around would cost a frame on every dispatch. create_command_function rejects reference parameters.
+        template<typename Result>
+        static Result invoke_fn(auto&& fn, auto&&... args)
+        {
+            return std::invoke(std::forward<decltype(fn)>(fn), std::forward<decltype(args)>(args)...);
         }
     };
 }
@@ -1,126 +1,293 @@
 #pragma once
+#include "command_args.h"
+#include "conversion_cache.h"
 #include "exceptions.h"
 #include "patron/results/command_result.h"
+#include "patron/results/precondition_result.h"
 #include "patron/utils/concepts.h"
+#include "patron/utils/throw.h"
+#include <expected>
 #include <functional>
+#include <optional>
+#include <stdexcept>
 
 namespace patron
 {
-    struct variant_function_wrapper_base
-    {
-        virtual ~variant_function_wrapper_base() = default;
-    };
+    class module_base;
+    class module_service_base;
 
-    template<typename ReturnType, typename... Args>
-    struct variant_function_wrapper : variant_function_wrapper_base
-    {
-        std::function<ReturnType(Args...)> func;
-        explicit variant_function_wrapper(std::function<ReturnType(Args...)> f) : func(std::move(f)) {}
-    };
+    // a step of running a command either produces its value or the result to report instead
+    template<typename T>
+    using expected_result = std::expected<T, command_result>;
 
-    class command_function
+    // awaits a started command in the caller's own frame, rather than wrapping it in another coroutine. an error
+    // from starting it is ready straight away, and what the command throws is reported as an error result unless
+    // exceptions is set.
+    template<typename Task>
+    class started_command
     {
+        using awaiter_type = decltype(utility::detail::get_awaiter(std::declval<Task>(), nullptr));
     public:
-        template<typename ReturnType, typename... Args>
-        command_function(std::function<ReturnType(Args...)> f, std::size_t target_arg_count)
-            : m_target_arg_count(target_arg_count),
-              m_wrapper(std::make_unique<variant_function_wrapper<ReturnType, Args...>>(std::move(f))) {}
+        started_command(expected_result<Task> task, bool exceptions)
+            : m_task(std::move(task)), m_exceptions(exceptions) {}
 
-        template<template<typename> typename TaskType = detail::no_task>
-            requires utility::is_awaitable<TaskType<command_result>>
-        TaskType<command_result> invoke_with_result(std::string_view name, std::size_t arg_count, bool exceptions, auto&&... args)
+        bool await_ready()
         {
-            if (arg_count < m_target_arg_count)
-            {
-                bad_argument_count arg_ex(name, arg_count, m_target_arg_count);
-                if (exceptions)
-                    throw arg_ex;
-                else
-                    co_return command_result::from_error(arg_ex.error(), arg_ex.what());
-            }
+            if (!m_task)
+                return true;
 
-            if (exceptions)
+            if constexpr (std::is_reference_v<awaiter_type>)
+                m_awaiter.emplace(static_cast<std::remove_reference_t<awaiter_type>&>(
+                    utility::detail::get_awaiter(std::move(*m_task), nullptr)));
+            else
             {
-                co_return co_await invoke<TaskType<command_result>>(std::forward<decltype(args)>(args)...);
+                // built in place, the awaiter may hold on to the task and not be movable
+                struct make_awaiter
+                {
+                    Task& task;
+                    operator awaiter_type() { return utility::detail::get_awaiter(std::move(task), nullptr); }
+                };
+                m_awaiter.emplace(make_awaiter { *m_task });
             }
-            else
+
+            return awaiter().await_ready();
+        }
+
+        template<typename Promise>
+        decltype(auto) await_suspend(std::coroutine_handle<Promise> handle)
+        {
+            return awaiter().await_suspend(handle);
+        }
+
+        command_result await_resume()
+        {
+            if (!m_task)
+                return std::move(m_task.error());
+
+        #if __cpp_exceptions
+            if (!m_exceptions)
             {
                 try
                 {
-                    co_return co_await invoke<TaskType<command_result>>(std::forward<decltype(args)>(args)...);
+                    return awaiter().await_resume();
                 }
                 catch (const bad_command_argument& e)
                 {
-                    co_return command_result::from_error(e.error(), e.what());
+                    return command_result::from_error(e);
                 }
                 catch (const std::exception& e)
                 {
-                    co_return command_result::from_error(e);
+                    return command_result::from_error(e);
                 }
             }
+        #endif
+
+            return awaiter().await_resume();
         }
+    private:
+        expected_result<Task> m_task;
+        bool m_exceptions;
+        std::optional<std::conditional_t<std::is_reference_v<awaiter_type>,
+                                         std::reference_wrapper<std::remove_reference_t<awaiter_type>>,
+                                         awaiter_type>> m_awaiter;
 
-        template<template<typename> typename TaskType = detail::no_task>
-            requires (!utility::is_awaitable<TaskType<command_result>>)
-        command_result invoke_with_result(std::string_view name, std::size_t arg_count, bool exceptions, auto&&... args)
+        auto& awaiter()
         {
-            if (arg_count < m_target_arg_count)
+            if constexpr (std::is_reference_v<awaiter_type>)
+                return m_awaiter->get();
+            else
+                return *m_awaiter;
+        }
+    };
+
+    namespace detail
+    {
+        // one address per type, what an erased thunk's type is checked by
+        template<typename T>
+        inline constexpr char function_type_tag = 0;
+    }
+
+    class command_function
+    {
+    public:
+        template<typename ReturnType>
+        using thunk_type = expected_result<ReturnType>(*)(module_base*, const command_args&, module_service_base*);
+
+        // gives the type reader slot of what a parameter is read as
+        using reader_slot_fn = std::size_t(*)();
+
+        // runs some of the command's sync preconditions, giving back the result to report if one isn't met
+        using precondition_fn = std::optional<command_result>(*)(const command_context&, module_service_base*);
+
+        // starts the command's idx-th async precondition
+        template<typename Task>
+        using async_precondition_fn = Task(*)(std::size_t idx, const command_context&);
+
+        // converts the arguments through the cache and sums their weights, see command_execution::score_overload
+        using score_fn = std::optional<float>(*)(const command_args&, detail::conversion_cache&, module_service_base*);
+
+        // the return type is fixed here, at registration, and is checked against the service's result type there.
+        // it's kept along with the thunk, so invoking with any other type fails instead of calling through the
+        // wrong pointer type. the same goes for the task async preconditions give back.
+        template<typename ReturnType, typename PreconditionTask = void>
+        command_function(thunk_type<ReturnType> thunk, std::size_t target_arg_count,
+                         std::span<const reader_slot_fn> reader_slots = {}, precondition_fn preconditions = nullptr,
+                         precondition_fn cooldowns = nullptr,
+                         async_precondition_fn<PreconditionTask> async_preconditions = nullptr,
+                         std::size_t async_precondition_count = 0, score_fn score = nullptr)
+            : m_target_arg_count(target_arg_count), m_thunk(reinterpret_cast<erased_thunk>(thunk)),
+              m_thunk_type(&detail::function_type_tag<ReturnType>), m_reader_slots(reader_slots),
+              m_preconditions(preconditions), m_cooldowns(cooldowns), m_async_preconditions(reinterpret_cast<erased_thunk>(async_preconditions)),
+              m_async_precondition_type(&detail::function_type_tag<PreconditionTask>),
+              m_async_precondition_count(async_precondition_count), m_score(score) {}
+
+        // the static preconditions, then the cooldowns, see command_execution::check_preconditions
+        std::optional<command_result> check_preconditions(const command_context& context, module_service_base* service) const
+        {
+            if (std::optional<command_result> unmet = check_static_preconditions(context, service))
+                return unmet;
+            return acquire_cooldowns(context, service);
+        }
+
+        // only the static preconditions, which can be checked for a command that may not run after all
+        std::optional<command_result> check_static_preconditions(const command_context& context, module_service_base* service) const
+        {
+            return m_preconditions ? m_preconditions(context, service) : std::nullopt;
+        }
+
+        // takes a use of each cooldown, once it's settled that the command runs
+        std::optional<command_result> acquire_cooldowns(const command_context& context, module_service_base* service) const
+        {
+            return m_cooldowns ? m_cooldowns(context, service) : std::nullopt;
+        }
+
+        bool has_async_preconditions() const { return m_async_precondition_count != 0; }
+
+        // awaits each async precondition in turn, giving back success once they're all met. it's a coroutine of
+        // its own, so it's only worth calling when there are some.
+        template<template<typename> typename TaskType>
+        TaskType<command_result> check_async_preconditions(command_context context) const
+        {
+            using task = TaskType<precondition_result>;
+            return run_async_preconditions<TaskType>(
+                restore<async_precondition_fn<task>, task>(m_async_preconditions, m_async_precondition_type),
+                m_async_precondition_count, std::move(context));
+        }
+
+        // checks the argument count, converts the arguments and calls the command, without waiting on what it
+        // returns: that's the command's result, or its task in coroutine mode. failing any of it gives back the
+        // result to report instead, and what's thrown is reported the same way unless exceptions is set. name is
+        // kept by a failed count's error, so it has to be static, like the command's registered name.
+        template<typename ReturnType>
+        expected_result<ReturnType> start(std::string_view name, bool exceptions, module_base* module,
+                                          const command_args& args, module_service_base* service) const
+        {
+            thunk_type<ReturnType> thunk = restore<thunk_type<ReturnType>, ReturnType>(m_thunk, m_thunk_type);
+            if (args.size() < m_target_arg_count)
             {
-                bad_argument_count arg_ex(name, arg_count, m_target_arg_count);
+                bad_argument_count arg_ex(name, args.size(), m_target_arg_count);
                 if (exceptions)
-                    throw arg_ex;
+                    utility::throw_exception(std::move(arg_ex));
                 else
-                    return command_result::from_error(arg_ex.error(), arg_ex.what());
+                    return std::unexpected(command_result::from_error(std::move(arg_ex)));
             }
 
-            if (exceptions)
-            {
-                return invoke<command_result>(std::forward<decltype(args)>(args)...);
-            }
-            else
+        #if __cpp_exceptions
+            if (!exceptions)
             {
                 try
                 {
-                    return invoke<command_result>(std::forward<decltype(args)>(args)...);
+                    return thunk(module, args, service);
                 }
                 catch (const bad_command_argument& e)
                 {
-                    return command_result::from_error(e.error(), e.what());
+                    return std::unexpected(command_result::from_error(e));
                 }
                 catch (const std::exception& e)
                 {
-                    return command_result::from_error(e);
+                    return std::unexpected(command_result::from_error(e));
                 }
             }
+        #endif
+
+            return thunk(module, args, service);
+        }
+
+        template<template<typename> typename TaskType = detail::no_task>
+            requires utility::is_awaitable<TaskType<command_result>>
+        TaskType<command_result> invoke_with_result(std::string_view name, bool exceptions, module_base* module,
+                                                    const command_args& args, module_service_base* service) const
+        {
+            if (std::optional<command_result> unmet = check_preconditions(args.context(), service))
+                co_return std::move(*unmet);
+            if (has_async_preconditions())
+            {
+                command_result met = co_await started_command<TaskType<command_result>>(
+                    check_async_preconditions<TaskType>(args.context()), exceptions);
+                if (!met.success())
+                    co_return met;
+            }
+
+            co_return co_await started_command<TaskType<command_result>>(
+                start<TaskType<command_result>>(name, exceptions, module, args, service), exceptions);
+        }
+
+        template<template<typename> typename TaskType = detail::no_task>
+            requires (!utility::is_awaitable<TaskType<command_result>>)
+        command_result invoke_with_result(std::string_view name, bool exceptions, module_base* module,
+                                          const command_args& args, module_service_base* service) const
+        {
+            if (std::optional<command_result> unmet = check_preconditions(args.context(), service))
+                return std::move(*unmet);
+
+            expected_result<command_result> result = start<command_result>(name, exceptions, module, args, service);
+            return result ? std::move(*result) : std::move(result.error());
+        }
+
+        std::size_t target_arg_count() const { return m_target_arg_count; }
+
+        // one per parameter that can be prefetched by an async type reader, null for the others
+        std::span<const reader_slot_fn> reader_slots() const { return m_reader_slots; }
+
+        // how well args fit the command when it's one of several overloads, nothing if one of them doesn't convert
+        std::optional<float> score(const command_args& args, detail::conversion_cache& cache, module_service_base* service) const
+        {
+            return m_score ? m_score(args, cache, service) : std::optional<float>(0.0f);
         }
     private:
+        using erased_thunk = void(*)();
+
         std::size_t m_target_arg_count;
-        std::unique_ptr<variant_function_wrapper_base> m_wrapper;
+        erased_thunk m_thunk;
+        const void* m_thunk_type;
+        std::span<const reader_slot_fn> m_reader_slots;
+        precondition_fn m_preconditions;
+        precondition_fn m_cooldowns;
+        erased_thunk m_async_preconditions;
+        const void* m_async_precondition_type;
+        std::size_t m_async_precondition_count;
+        score_fn m_score;
 
-        template<typename T>
-        T invoke(auto&&... args)
+        // the thunk as the type it was registered with, asking for any other is a bug in the service
+        template<typename Fn, typename T>
+        static Fn restore(erased_thunk thunk, const void* type)
         {
-            using WrapperType = variant_function_wrapper<T, std::remove_cvref_t<decltype(args)>...>;
-            if (WrapperType* fw = dynamic_cast<WrapperType*>(m_wrapper.get()))
-                return fw->func(std::forward<decltype(args)>(args)...);
-            return T{};
+            if (type != &detail::function_type_tag<T>)
+                utility::throw_exception(std::logic_error("command_function invoked with a type it wasn't registered with"));
+            return reinterpret_cast<Fn>(thunk);
         }
 
-        template<utility::is_awaitable T>
-        T invoke(auto&&... args)
+        template<template<typename> typename TaskType>
+        static TaskType<command_result> run_async_preconditions(async_precondition_fn<TaskType<precondition_result>> check,
+                                                                std::size_t count, command_context context)
         {
-            using ValueType = utility::await_result_t<T>;
-            using WrapperType = variant_function_wrapper<T, std::remove_cvref_t<decltype(args)>...>;
-
-            if (WrapperType* fw = dynamic_cast<WrapperType*>(m_wrapper.get()))
+            for (std::size_t i = 0; i < count; ++i)
             {
-                if constexpr (std::is_void_v<ValueType>)
-                    co_await fw->func(std::forward<decltype(args)>(args)...);
-                else
-                    co_return co_await fw->func(std::forward<decltype(args)>(args)...);
+                precondition_result result = co_await check(i, context);
+                if (!result.success())
+                    co_return command_result::from_error(command_error::unmet_precondition, result.message_storage());
             }
-
-            co_return ValueType{};
+            co_return command_result::from_success();
         }
     };
 }
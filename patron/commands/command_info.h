@@ -6,12 +6,21 @@ namespace patron
 {
     class module_base;
 
+    namespace detail
+    {
+        template<typename... Modules>
+        struct static_command_table;
+    }
+
     class command_info
     {
         template<template<typename> typename T>
             requires (utility::specialization_of<T<void>, detail::no_task> || utility::is_awaitable<T<command_result>>)
         friend class module_service;
 
+        template<typename... Modules>
+        friend struct detail::static_command_table;
+
         struct command_data
         {
             std::string_view m_name;
@@ -21,13 +30,16 @@ namespace patron
             std::string_view m_remarks;
             std::span<const char*> m_aliases;
             std::string_view m_usage;
+            std::span<const group> m_groups;
 
             consteval command_data(
                 std::meta::info command_info,
                 std::optional<std::meta::info> summary_info,
                 std::optional<std::meta::info> remarks_info,
                 std::optional<std::meta::info> alias_info,
-                utility::static_string_view usage)
+                utility::static_string_view usage,
+                std::optional<std::meta::info> module_group_info = std::nullopt,
+                std::optional<std::meta::info> group_info = std::nullopt)
                 : m_summary(utility::extract_text<patron::summary>(summary_info, &summary::text)),
                   m_remarks(utility::extract_text<patron::remarks>(remarks_info, &remarks::text)),
                   m_aliases(utility::extract_span<patron::alias>(alias_info, &alias::aliases)),
@@ -37,11 +49,18 @@ namespace patron
                 m_name = std::string_view(cmd.text);
                 m_ignore_extra_args = cmd.ignore_extra_args;
                 m_remainder = cmd.remainder;
+
+                std::vector<group> groups;
+                for (std::optional<std::meta::info> info : { module_group_info, group_info })
+                    if (info)
+                        groups.push_back(std::meta::extract<group>(*info));
+                m_groups = define_static_array(groups);
             }
         };
     public:
-        command_info(const command_data& data, const module_base* module, command_function&& function)
-            : m_data(data), m_function(std::move(function)), m_module(module) {}
+        // lazy means module is a detail::lazy_module_base standing in for the module the command runs on
+        command_info(const command_data& data, module_base* module, command_function&& function, bool lazy = false)
+            : m_data(data), m_function(std::move(function)), m_module(module), m_lazy(lazy) {}
 
         bool matches(std::string_view str, bool case_sensitive) const;
 
@@ -50,12 +69,19 @@ namespace patron
         std::string_view remarks() const { return m_data.m_remarks; }
         std::span<const char*> aliases() const { return m_data.m_aliases; }
         std::string_view usage() const { return m_data.m_usage; }
+        // the groups the command is under, outermost first
+        std::span<const group> groups() const { return m_data.m_groups; }
 
         const command_function& function() const { return m_function; }
+        // the module the command was registered with, which for a lazily registered module only holds its metadata
         const module_base* module() const { return m_module; }
+        // the module the command runs on, constructing it first if it was registered lazily. defined in
+        // module_base.h.
+        module_base* instance() const;
     private:
         command_data m_data;
         command_function m_function;
-        const module_base* m_module;
+        module_base* m_module;
+        bool m_lazy;
     };
 }
@@ -0,0 +1,76 @@
+#pragma once
+#include "patron/results/type_reader_result.h"
+#include <memory_resource>
+#include <string_view>
+#include <vector>
+
+namespace patron
+{
+    namespace detail
+    {
+        // the arguments of one message converted while picking between overloads. each argument is converted to
+        // each type once, no matter how many candidates read it as that type, and a failed conversion is kept too
+        // so the next candidate that needs it fails on a lookup.
+        class conversion_cache
+        {
+        public:
+            struct conversion
+            {
+                std::size_t slot;
+                std::size_t index;
+                // null when the conversion failed
+                void* value;
+                void (*destroy)(std::pmr::polymorphic_allocator<>&, void*);
+                float weight;
+            };
+
+            explicit conversion_cache(std::pmr::memory_resource* resource)
+                : m_allocator(resource), m_conversions(resource) {}
+
+            conversion_cache(const conversion_cache&) = delete;
+            conversion_cache& operator=(const conversion_cache&) = delete;
+
+            ~conversion_cache()
+            {
+                for (conversion& conversion : m_conversions)
+                    if (conversion.value)
+                        conversion.destroy(m_allocator, conversion.value);
+            }
+
+            // argument index converted to the type with reader slot slot, null if it hasn't been yet. only valid
+            // until the next add.
+            const conversion* find(std::size_t slot, std::size_t index) const
+            {
+                for (const conversion& conversion : m_conversions)
+                    if (conversion.slot == slot && conversion.index == index)
+                        return &conversion;
+                return nullptr;
+            }
+
+            template<typename T>
+            const conversion& add(std::size_t slot, std::size_t index, T&& value, float weight)
+            {
+                using U = std::remove_cvref_t<T>;
+                return m_conversions.emplace_back(slot, index, m_allocator.new_object<U>(std::forward<T>(value)),
+                    [](std::pmr::polymorphic_allocator<>& allocator, void* value) {
+                        allocator.delete_object(static_cast<U*>(value));
+                    }, weight);
+            }
+
+            const conversion& add_failure(std::size_t slot, std::size_t index)
+            {
+                return m_conversions.emplace_back(slot, index, nullptr, nullptr, 0.0f);
+            }
+
+            // what a cached value is handed to the command with, in place of a type reader's result
+            static const type_reader_result* converted()
+            {
+                static const type_reader_result result = type_reader_result::from_success();
+                return &result;
+            }
+        private:
+            std::pmr::polymorphic_allocator<> m_allocator;
+            std::pmr::vector<conversion> m_conversions;
+        };
+    }
+}
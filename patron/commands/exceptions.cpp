@@ -1,20 +1,45 @@
 #include "exceptions.h"
+#include "patron/utils/strings.h"
+#include <algorithm>
 #include <format>
 
 namespace patron
 {
-    bad_argument_count::bad_argument_count(std::string_view command, std::size_t arg_count, std::size_t target_arg_count)
-        : m_arg_count(arg_count), m_command(command), m_target_arg_count(target_arg_count),
-          m_formatted_message(std::format(
-              "{}: Ran with {} arguments, expects at least {}",
-              command, arg_count, target_arg_count
-          )) {}
+    namespace detail
+    {
+        argument_text::argument_text(std::string_view text)
+            : m_size(text.size())
+        {
+            if (text.size() <= m_buffer.size())
+                std::ranges::copy(text, m_buffer.begin());
+            else
+                m_long = text;
+        }
 
-    bad_command_argument::bad_command_argument(command_error error, std::string_view arg, std::size_t index,
-                                               std::string_view command, std::string_view message)
-        : m_arg(arg), m_command(command), m_error(error), m_index(index), m_message(message),
-          m_formatted_message(std::format(
-              "{}: Failed to convert argument {} ({}): {}",
-              command, index, arg, message
-          )) {}
+        argument_text::operator std::string_view() const
+        {
+            return m_size <= m_buffer.size() ? std::string_view(m_buffer.data(), m_size) : std::string_view(m_long);
+        }
+    }
+
+    const char* bad_argument_count::what() const noexcept
+    {
+        return m_what.get([this] {
+            return std::format("{}: Ran with {} arguments, expects at least {}", m_command, m_arg_count, m_target_arg_count);
+        }).c_str();
+    }
+
+    std::string_view bad_command_argument::message() const
+    {
+        if (!m_target || !m_message.view().empty())
+            return m_message.view();
+        return m_type_message.get([this] { return "Failed to convert from string to " + utility::demangle(m_target->name()); });
+    }
+
+    const char* bad_command_argument::what() const noexcept
+    {
+        return m_what.get([this] {
+            return std::format("{}: Failed to convert argument {} ({}): {}", m_command, m_index, arg(), message());
+        }).c_str();
+    }
 }
@@ -1,42 +1,102 @@
 #pragma once
-#include "patron/results/command_error.h"
+#include "patron/results/result.h"
+#include <array>
 #include <exception>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <typeinfo>
 
 namespace patron
 {
+    namespace detail
+    {
+        // an argument's text, copied out of the message it came from. most are short enough to stay inline.
+        class argument_text
+        {
+        public:
+            explicit argument_text(std::string_view text);
+            operator std::string_view() const;
+        private:
+            std::array<char, 32> m_buffer{};
+            std::size_t m_size;
+            std::string m_long;
+        };
+
+        // text formatted the first time it's asked for, by whichever thread asks first. a copy doesn't take the
+        // text along, it formats its own when it's asked for it.
+        class lazy_text
+        {
+        public:
+            lazy_text() = default;
+            lazy_text(const lazy_text&) noexcept {}
+
+            // the text was formatted from fields that are being replaced
+            lazy_text& operator=(const lazy_text&) noexcept
+            {
+                std::destroy_at(&m_once);
+                std::construct_at(&m_once);
+                m_text.clear();
+                return *this;
+            }
+
+            template<typename Format>
+            const std::string& get(Format&& format) const
+            {
+                std::call_once(m_once, [&] { m_text = format(); });
+                return m_text;
+            }
+        private:
+            mutable std::once_flag m_once;
+            mutable std::string m_text;
+        };
+    }
+
+    // both of these only record what went wrong: the command's registered name, which is static, and a copy of the
+    // argument's text, since the message it came from goes away with the dispatch. the human-readable message is
+    // formatted the first time what() is called, so reporting one in a result that's never read costs nothing more.
     class bad_argument_count : public std::exception
     {
     public:
-        bad_argument_count(std::string_view command, std::size_t arg_count, std::size_t target_arg_count);
+        bad_argument_count(std::string_view command, std::size_t arg_count, std::size_t target_arg_count)
+            : m_arg_count(arg_count), m_command(command), m_target_arg_count(target_arg_count) {}
         std::size_t arg_count() const { return m_arg_count; }
-        const std::string& command() const { return m_command; }
+        std::string_view command() const { return m_command; }
         static constexpr command_error error() { return command_error::bad_arg_count; }
         std::size_t target_arg_count() const { return m_target_arg_count; }
-        const char* what() const noexcept override { return m_formatted_message.c_str(); }
+        const char* what() const noexcept override;
     private:
         std::size_t m_arg_count;
-        std::string m_command;
+        std::string_view m_command;
         std::size_t m_target_arg_count;
-        std::string m_formatted_message;
+        detail::lazy_text m_what;
     };
 
     class bad_command_argument : public std::exception
     {
     public:
         bad_command_argument(command_error error, std::string_view arg, std::size_t index,
-                             std::string_view command, std::string_view message);
-        const std::string& arg() const { return m_arg; }
-        const std::string& command() const { return m_command; }
+                             std::string_view command, result_message message)
+            : m_arg(arg), m_command(command), m_error(error), m_index(index), m_message(std::move(message)) {}
+
+        // a failed parse into target, the message names the type
+        bad_command_argument(std::string_view arg, std::size_t index, std::string_view command, const std::type_info& target)
+            : m_arg(arg), m_command(command), m_error(command_error::parse_failed), m_index(index), m_target(&target) {}
+
+        std::string_view arg() const { return m_arg; }
+        std::string_view command() const { return m_command; }
         command_error error() const { return m_error; }
         std::size_t index() const { return m_index; }
-        const std::string& message() const { return m_message; }
-        const char* what() const noexcept override { return m_formatted_message.c_str(); }
+        std::string_view message() const;
+        const char* what() const noexcept override;
     private:
-        std::string m_arg;
-        std::string m_command;
+        detail::argument_text m_arg;
+        std::string_view m_command;
         command_error m_error;
         std::size_t m_index;
-        std::string m_message;
-        std::string m_formatted_message;
+        result_message m_message;
+        const std::type_info* m_target{};
+        detail::lazy_text m_type_message;
+        detail::lazy_text m_what;
     };
 }
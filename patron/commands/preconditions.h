@@ -0,0 +1,32 @@
+#pragma once
+#include "command_context.h"
+#include "patron/results/precondition_result.h"
+#include "patron/utils/concepts.h"
+#include <cstdint>
+
+namespace patron
+{
+    // preconditions are annotations on a command or on its module, where they apply to all of its commands. any
+    // annotation whose type has a check(const command_context&) const is one. they're run before the command's
+    // arguments are converted: the module's before the command's, and static ones (check gives back a
+    // precondition_result) before dynamic ones like cooldown, before async ones (check gives back the service's
+    // task of precondition_result, only module_service in coroutine mode runs those).
+    template<typename T>
+    concept static_precondition = requires(const T& precondition, const command_context& context) {
+        { precondition.check(context) } -> std::same_as<precondition_result>;
+    };
+
+    template<typename T>
+    concept async_precondition = !static_precondition<T> && requires(const T& precondition, const command_context& context) {
+        { precondition.check(context) } -> utility::is_awaitable;
+    };
+
+    // lets each user run the command uses times per period_ms, refilling evenly over the period. on a module,
+    // the uses are shared by all of its commands. with per_user unset, every user shares the same uses.
+    struct cooldown
+    {
+        std::uint32_t uses = 1;
+        std::uint64_t period_ms = 0;
+        bool per_user = true;
+    };
+}
@@ -1,5 +1,6 @@
 #pragma once
 #include "patron/results/type_reader_result.h"
+#include "patron/utils/throw.h"
 #include <algorithm>
 #include <any>
 #include <meta>
@@ -33,19 +34,29 @@ namespace patron
         float m_weight;
     };
 
+    namespace detail
+    {
+        struct type_reader_erased
+        {
+            virtual ~type_reader_erased() = default;
+        };
+    }
+
     template<typename T>
-    class type_reader_base
+    class type_reader_base : public detail::type_reader_erased
     {
     public:
         using value_type = T;
 
-        virtual ~type_reader_base() = default;
-        virtual type_reader_result read(const std::string& input) = 0;
+        virtual type_reader_result read(std::string_view input) = 0;
+
+        // readers are reused across reads, this drops the previous read's results but keeps their storage
+        void reset() { m_results.clear(); }
 
         const T& top_result() const
         {
             if (m_results.empty())
-                throw std::logic_error("Tried to get top result from type reader with no results");
+                utility::throw_exception(std::logic_error("Tried to get top result from type reader with no results"));
             return std::ranges::max_element(m_results, {}, &type_reader_value<T>::weight)->value();
         }
 
@@ -63,13 +74,12 @@ namespace patron
         std::vector<type_reader_value<T>> m_results;
     };
 
-    template<typename Derived, typename T>
-    struct type_reader : type_reader_base<T>
+    namespace detail
     {
-        static type_reader<Derived, T>* create(std::span<const std::any> extra_data)
+        // sets each of the reader's members to the first extra data of the same type
+        template<typename Derived>
+        void inject_extra_data(Derived& reader, std::span<const std::any> extra_data)
         {
-            Derived* result = new Derived;
-
             constexpr std::meta::access_context ctx = std::meta::access_context::unchecked();
             template for (constexpr std::meta::info member : define_static_array(std::meta::nonstatic_data_members_of(^^Derived, ctx)))
             {
@@ -78,12 +88,21 @@ namespace patron
                 {
                     if (const Member* casted = std::any_cast<Member>(&data))
                     {
-                        result->[:member:] = *casted;
+                        reader.[:member:] = *casted;
                         break;
                     }
                 }
             }
+        }
+    }
 
+    template<typename Derived, typename T>
+    struct type_reader : type_reader_base<T>
+    {
+        static type_reader<Derived, T>* create(std::span<const std::any> extra_data)
+        {
+            Derived* result = new Derived;
+            detail::inject_extra_data(*result, extra_data);
             return result;
         }
     };
@@ -12,4 +12,18 @@ namespace patron
                 return true;
         return false;
     }
+
+    namespace detail
+    {
+        module_base* lazy_module_base::construct()
+        {
+            std::call_once(m_once, [this] {
+                m_owned = make();
+                m_owned->m_data = m_data;
+                m_owned->m_commands_owner = this;
+                m_instance.store(m_owned.get(), std::memory_order_release);
+            });
+            return m_instance.load(std::memory_order_relaxed);
+        }
+    }
 }
@@ -1,10 +1,20 @@
 #pragma once
 #include "patron/commands/command_info.h"
+#include <atomic>
+#include <memory>
+#include <mutex>
 
 namespace patron
 {
+    namespace detail
+    {
+        class lazy_module_base;
+    }
+
     class module_base
     {
+        friend class detail::lazy_module_base;
+
         template<template<typename> typename T>
             requires (utility::specialization_of<T<void>, detail::no_task> || utility::is_awaitable<T<command_result>>)
         friend class module_service;
@@ -37,9 +47,52 @@ namespace patron
         std::string_view summary() const { return m_data.m_summary; }
         std::string_view remarks() const { return m_data.m_remarks; }
         std::span<const char*> aliases() const { return m_data.m_aliases; }
-        std::span<const command_info> commands() const { return m_commands; }
+        // a lazily constructed module's commands stay with its stand-in, which it hands them out from
+        std::span<const command_info> commands() const { return m_commands_owner ? m_commands_owner->m_commands : m_commands; }
     private:
         std::vector<command_info> m_commands;
+        const module_base* m_commands_owner = nullptr;
         module_data m_data;
     };
+
+    namespace detail
+    {
+        // registered in place of a module when lazy_modules is set. it holds the module's metadata and commands
+        // from the start, and constructs the module itself the first time instance() is called. the instance
+        // gets the same metadata and reports the same commands, which stay owned here.
+        class lazy_module_base : public module_base
+        {
+        public:
+            // safe to call from any number of threads at once, only one of them constructs the module. if its
+            // constructor throws, that call throws and the next one tries again.
+            module_base* instance()
+            {
+                if (module_base* module = m_instance.load(std::memory_order_acquire))
+                    return module;
+                return construct();
+            }
+
+            bool constructed() const { return m_instance.load(std::memory_order_acquire) != nullptr; }
+        protected:
+            virtual std::unique_ptr<module_base> make() const = 0;
+        private:
+            std::once_flag m_once;
+            std::unique_ptr<module_base> m_owned;
+            std::atomic<module_base*> m_instance{};
+
+            module_base* construct();
+        };
+
+        template<std::derived_from<module_base> M>
+        class lazy_module final : public lazy_module_base
+        {
+        protected:
+            std::unique_ptr<module_base> make() const override { return std::make_unique<M>(); }
+        };
+    }
+
+    inline module_base* command_info::instance() const
+    {
+        return m_lazy ? static_cast<detail::lazy_module_base*>(m_module)->instance() : m_module;
+    }
 }
@@ -1,26 +1,79 @@
 #pragma once
+#include "patron/commands/exceptions.h"
 #include "result.h"
+#include <variant>
 
 namespace patron
 {
     class command_result : public result
     {
     public:
-        static command_result from_success(std::string_view message = "")
-        { return command_result(std::nullopt, message); }
+        static command_result from_success(result_message message = {})
+        { return command_result(std::nullopt, std::move(message)); }
 
-        static command_result from_error(std::string_view message = "")
-        { return command_result(command_error::unsuccessful, message); }
+        static command_result from_error(result_message message = {})
+        { return command_result(command_error::unsuccessful, std::move(message)); }
 
         static command_result from_error(const std::exception& e)
-        { return command_result(command_error::exception, e.what()); }
+        { return command_result(command_error::exception, std::string_view(e.what())); }
 
-        static command_result from_error(command_error error, std::string_view message)
-        { return command_result(error, message); }
+        static command_result from_error(command_error error, result_message message)
+        { return command_result(error, std::move(message)); }
+
+        // these keep the error, whose message is only formatted once message() is first called
+        static command_result from_error(bad_argument_count e)
+        { return command_result(std::move(e)); }
+
+        static command_result from_error(bad_command_argument e)
+        { return command_result(std::move(e)); }
 
         command_result() = default;
+
+        command_result(const command_result& other)
+            : result(other), m_details(other.m_details) { refer_to_details(); }
+
+        command_result(command_result&& other) noexcept
+            : result(std::move(other)), m_details(std::move(other.m_details)) { refer_to_details(); }
+
+        command_result& operator=(const command_result& other)
+        {
+            result::operator=(other);
+            m_details = other.m_details;
+            refer_to_details();
+            return *this;
+        }
+
+        command_result& operator=(command_result&& other) noexcept
+        {
+            result::operator=(std::move(other));
+            m_details = std::move(other.m_details);
+            refer_to_details();
+            return *this;
+        }
+
+        const bad_argument_count* argument_count_error() const { return std::get_if<bad_argument_count>(&m_details); }
+        const bad_command_argument* argument_error() const { return std::get_if<bad_command_argument>(&m_details); }
     private:
-        command_result(const std::optional<command_error>& error, std::string_view message)
-            : result(error, message) {}
+        std::variant<std::monostate, bad_argument_count, bad_command_argument> m_details;
+
+        command_result(const std::optional<command_error>& error, result_message message)
+            : result(error, std::move(message)) {}
+
+        template<typename E> requires std::derived_from<E, std::exception>
+        explicit command_result(E e)
+            : result(e.error(), {}), m_details(std::move(e))
+        {
+            refer_to_details();
+        }
+
+        // an argument error's message is the error's what(), referred to rather than formatted up front, so it has
+        // to be pointed at this result's own copy of the error whenever the result is copied or moved
+        void refer_to_details()
+        {
+            if (const bad_argument_count* e = argument_count_error())
+                m_message = result_message::deferred(*e);
+            else if (const bad_command_argument* e = argument_error())
+                m_message = result_message::deferred(*e);
+        }
     };
 }
@@ -0,0 +1,21 @@
+#pragma once
+#include "result.h"
+
+namespace patron
+{
+    // what a precondition gives back, a command whose precondition isn't met fails with unmet_precondition
+    class precondition_result : public result
+    {
+    public:
+        static precondition_result from_success()
+        { return precondition_result(std::nullopt, {}); }
+
+        static precondition_result from_error(result_message message)
+        { return precondition_result(command_error::unmet_precondition, std::move(message)); }
+
+        precondition_result() = default;
+    private:
+        precondition_result(const std::optional<command_error>& error, result_message message)
+            : result(error, std::move(message)) {}
+    };
+}
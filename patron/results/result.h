@@ -1,22 +1,144 @@
 #pragma once
 #include "command_error.h"
+#include <algorithm>
+#include <format>
+#include <iterator>
+#include <memory_resource>
 #include <optional>
+#include <span>
 #include <string>
+#include <variant>
 
 namespace patron
 {
+    // the text of a result. string literals and text in caller-supplied storage are referenced as they are, anything
+    // else is copied into an owned string, from a memory resource when the caller has a pool or arena for them.
+    class result_message
+    {
+    public:
+        constexpr result_message() = default;
+
+        // string literals, and other constant character arrays, are referenced without copying
+        template<std::size_t N>
+        consteval result_message(const char (&literal)[N])
+            : m_storage(std::string_view(literal)) {}
+
+        // a character array that isn't constant is a buffer filled at runtime, so its text up to the first null is
+        // copied like any other runtime string
+        template<std::size_t N>
+        result_message(char (&buffer)[N])
+            : result_message(std::string_view(buffer, std::ranges::find(buffer, '\0'))) {}
+
+        // a C string only known at runtime is copied
+        template<typename T> requires std::same_as<std::remove_cvref_t<T>, const char*> || std::same_as<std::remove_cvref_t<T>, char*>
+        result_message(T&& text)
+            : result_message(text ? std::string_view(text) : std::string_view()) {}
+
+        result_message(std::string_view message)
+        {
+            if (!message.empty())
+                m_storage.emplace<std::string>(message);
+        }
+
+        result_message(const std::string& message)
+            : result_message(std::string_view(message)) {}
+
+        result_message(std::string&& message)
+        {
+            if (!message.empty())
+                m_storage.emplace<std::string>(std::move(message));
+        }
+
+        // copies text into memory from resource, which has to outlive the message. a copy of the message allocates
+        // from the default resource, as copies of pmr strings do, a move keeps resource.
+        static result_message allocated(std::string_view text, std::pmr::memory_resource* resource)
+        {
+            result_message out;
+            if (!text.empty())
+                out.m_storage.emplace<std::pmr::string>(text, resource);
+            return out;
+        }
+
+        // the same, formatting straight into memory from resource
+        template<typename... Args>
+        static result_message format_allocated(std::pmr::memory_resource* resource, std::format_string<Args...> fmt,
+                                               Args&&... args)
+        {
+            result_message out;
+            std::pmr::string& text = out.m_storage.emplace<std::pmr::string>(resource);
+            std::format_to(std::back_inserter(text), fmt, std::forward<Args>(args)...);
+            return out;
+        }
+
+        // references text without copying it, the storage has to outlive every result that holds it
+        static result_message borrowed(std::string_view text)
+        {
+            result_message out;
+            out.m_storage.emplace<std::string_view>(text);
+            return out;
+        }
+
+        // the text of source's what(), only asked for once the message is read, like an argument error's, which
+        // is formatted then. referenced like borrowed(), source has to outlive every result that holds it.
+        template<typename T>
+        static result_message deferred(const T& source)
+        {
+            result_message out;
+            out.m_storage.emplace<deferred_text>(deferred_text { &source, [](const void* s) {
+                return std::string_view(static_cast<const T*>(s)->what());
+            } });
+            return out;
+        }
+
+        // formats straight into storage, truncating the text if it doesn't fit, and references it like borrowed()
+        template<typename... Args>
+        static result_message format_into(std::span<char> storage, std::format_string<Args...> fmt, Args&&... args)
+        {
+            auto [out, _] = std::format_to_n(storage.data(), storage.size(), fmt, std::forward<Args>(args)...);
+            return borrowed(std::string_view(storage.data(), out));
+        }
+
+        // whether the text lives as long as the message does, rather than in storage it only references
+        bool owned() const
+        {
+            return std::holds_alternative<std::string>(m_storage) || std::holds_alternative<std::pmr::string>(m_storage);
+        }
+
+        std::string_view view() const
+        {
+            if (const std::string_view* sv = std::get_if<std::string_view>(&m_storage))
+                return *sv;
+            if (const std::string* s = std::get_if<std::string>(&m_storage))
+                return *s;
+            if (const std::pmr::string* s = std::get_if<std::pmr::string>(&m_storage))
+                return *s;
+            if (const deferred_text* d = std::get_if<deferred_text>(&m_storage))
+                return d->text(d->source);
+            return {};
+        }
+    private:
+        struct deferred_text
+        {
+            const void* source;
+            std::string_view (*text)(const void* source);
+        };
+
+        std::variant<std::monostate, std::string_view, std::string, std::pmr::string, deferred_text> m_storage;
+    };
+
     class result
     {
     public:
         std::optional<command_error> error() const { return m_error; }
-        const std::string& message() const { return m_message; }
+        std::string_view message() const { return m_message.view(); }
+        const result_message& message_storage() const { return m_message; }
         bool success() const { return !m_error; }
         result() : m_error(std::nullopt) {}
     protected:
         std::optional<command_error> m_error;
-        std::string m_message;
+        result_message m_message;
 
-        result(const std::optional<command_error>& error, std::string_view message)
-            : m_error(error), m_message(message) {}
+        result(const std::optional<command_error>& error, result_message message)
+            : m_error(error), m_message(std::move(message)) {}
     };
 }
@@ -6,15 +6,15 @@ namespace patron
     class type_reader_result : public result
     {
     public:
-        static type_reader_result from_success(std::string_view message = "")
-        { return type_reader_result(std::nullopt, message); }
+        static type_reader_result from_success(result_message message = {})
+        { return type_reader_result(std::nullopt, std::move(message)); }
 
-        static type_reader_result from_error(command_error error, std::string_view message)
-        { return type_reader_result(error, message); }
+        static type_reader_result from_error(command_error error, result_message message)
+        { return type_reader_result(error, std::move(message)); }
 
         type_reader_result() = default;
     private:
-        type_reader_result(const std::optional<command_error>& error, std::string_view message)
-            : result(error, message) {}
+        type_reader_result(const std::optional<command_error>& error, result_message message)
+            : result(error, std::move(message)) {}
     };
 }
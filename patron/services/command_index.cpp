@@ -0,0 +1,121 @@
+#include "command_index.h"
+#include "patron/utils/case_fold.h"
+#include "patron/utils/strings.h"
+#include <algorithm>
+
+namespace patron
+{
+    void command_index::add(const command_info& cmd)
+    {
+        // the nodes the command's groups lead to, one for every combination of their names and aliases
+        std::vector<std::uint32_t> parents { 0 };
+        for (const group& group : cmd.groups())
+        {
+            std::vector<std::uint32_t> next;
+            auto add_group = [this, &next](std::uint32_t parent, std::string_view key) {
+                // an alias can fold to the same key as the group's name
+                const std::uint32_t node = add_child(parent, key);
+                if (std::ranges::find(next, node) == next.end())
+                    next.push_back(node);
+            };
+
+            for (std::uint32_t parent : parents)
+            {
+                add_group(parent, group.text);
+                for (std::string_view alias : group.aliases)
+                    add_group(parent, alias);
+            }
+            parents = std::move(next);
+        }
+
+        insert(parents, cmd);
+    }
+
+    std::span<const command_info* const> command_index::find(std::string_view name) const
+    {
+        const std::uint32_t node = child(0, name);
+        if (node == npos)
+            return {};
+        return m_nodes[node].commands;
+    }
+
+    command_route command_index::route(std::string_view first, std::span<const std::string_view> rest) const
+    {
+        std::uint32_t node = child(0, first);
+        if (node == npos)
+            return {};
+
+        command_route result { m_nodes[node].commands, 0 };
+        for (std::size_t i = 0; i < rest.size(); ++i)
+        {
+            node = child(node, rest[i]);
+            if (node == npos)
+                break;
+            if (!m_nodes[node].commands.empty())
+                result = command_route { m_nodes[node].commands, i + 1 };
+        }
+
+        return result;
+    }
+
+    std::uint32_t command_index::child(std::uint32_t parent, std::string_view token) const
+    {
+        const auto& children = m_nodes[parent].children;
+        auto it = m_case_sensitive ? children.find(token) : children.find(std::string_view(folded_token(token)));
+        return it != children.end() ? it->second : npos;
+    }
+
+    std::uint32_t command_index::add_child(std::uint32_t parent, std::string_view token)
+    {
+        if (std::uint32_t existing = child(parent, token); existing != npos)
+            return existing;
+
+        const auto node = static_cast<std::uint32_t>(m_nodes.size());
+        m_nodes.emplace_back();
+        m_nodes[parent].children.emplace(m_case_sensitive ? std::string(token) : utility::fold_case(token), node);
+        return node;
+    }
+
+    void command_index::insert(std::span<const std::uint32_t> parents, const command_info& cmd)
+    {
+        for (std::uint32_t parent : parents)
+        {
+            auto insert_at = [this, parent, &cmd](std::string_view key) {
+                // an alias can fold to the same key as the command's name, don't list the command twice
+                const std::uint32_t node = add_child(parent, key);
+                std::vector<const command_info*>& commands = m_nodes[node].commands;
+                if (commands.empty() || commands.back() != &cmd)
+                    commands.push_back(&cmd);
+            };
+
+            insert_at(cmd.name());
+            for (std::string_view alias : cmd.aliases())
+                insert_at(alias);
+        }
+    }
+
+    std::size_t command_index::hasher::operator()(std::string_view str) const
+    {
+        return utility::shash(str, true);
+    }
+
+    command_index::folded_token::folded_token(std::string_view token)
+    {
+        utility::for_each_folded_byte(token, [this](char c) {
+            if (m_size < m_buffer.size())
+                m_buffer[m_size] = c;
+            else
+            {
+                if (m_long.empty())
+                    m_long.assign(m_buffer.data(), m_size);
+                m_long += c;
+            }
+            ++m_size;
+        });
+    }
+
+    command_index::folded_token::operator std::string_view() const
+    {
+        return m_size <= m_buffer.size() ? std::string_view(m_buffer.data(), m_size) : std::string_view(m_long);
+    }
+}
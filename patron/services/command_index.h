@@ -0,0 +1,97 @@
+#pragma once
+#include "patron/commands/command_info.h"
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace patron
+{
+    // commands found by name, keeping the snapshot of the index they came from alive for as long as they're held
+    class command_matches
+    {
+    public:
+        command_matches() = default;
+        command_matches(std::shared_ptr<const void> owner, std::span<const command_info* const> matches)
+            : m_owner(std::move(owner)), m_matches(matches) {}
+
+        auto begin() const { return m_matches.begin(); }
+        auto end() const { return m_matches.end(); }
+        std::size_t size() const { return m_matches.size(); }
+        bool empty() const { return m_matches.empty(); }
+        const command_info* front() const { return m_matches.front(); }
+        const command_info* operator[](std::size_t idx) const { return m_matches[idx]; }
+    private:
+        std::shared_ptr<const void> m_owner;
+        std::span<const command_info* const> m_matches;
+    };
+
+    // where a message's leading tokens led in the index: the commands at the end of the path, and how many tokens
+    // after the first one the path took up
+    struct command_route
+    {
+        std::span<const command_info* const> matches;
+        std::size_t consumed = 0;
+    };
+
+    // a trie over tokens. each command sits at the end of the path made of its groups and then its name, under
+    // every combination of their aliases too. routing takes one lookup per token of the path, so a command in a
+    // deep group is found as fast as a flat one with the same number of tokens.
+    class command_index
+    {
+    public:
+        explicit command_index(bool case_sensitive = false)
+            : m_case_sensitive(case_sensitive)
+        {
+            m_nodes.emplace_back();
+        }
+
+        void add(const command_info& cmd);
+
+        // commands called name that aren't in a group
+        std::span<const command_info* const> find(std::string_view name) const;
+
+        // follows first and then rest down the trie as far as they go, and settles on the longest path that ends
+        // in commands. the tokens after it are the command's arguments. matches is empty when no path did.
+        command_route route(std::string_view first, std::span<const std::string_view> rest) const;
+    private:
+        struct hasher
+        {
+            using is_transparent = void;
+            std::size_t operator()(std::string_view str) const;
+        };
+
+        static constexpr std::uint32_t npos = static_cast<std::uint32_t>(-1);
+
+        struct node
+        {
+            // keys are stored case-folded when lookup is case-insensitive, and a token is folded once before it's
+            // looked up, so hashing and comparing are bytewise either way
+            std::unordered_map<std::string, std::uint32_t, hasher, std::equal_to<>> children;
+            std::vector<const command_info*> commands;
+        };
+
+        // a token folded the way keys are, kept on the stack unless it's unusually long
+        class folded_token
+        {
+        public:
+            explicit folded_token(std::string_view token);
+            operator std::string_view() const;
+        private:
+            std::array<char, 64> m_buffer;
+            std::size_t m_size = 0;
+            std::string m_long;
+        };
+
+        bool m_case_sensitive;
+        // the root is the first node, children refer to others by their position
+        std::vector<node> m_nodes;
+
+        std::uint32_t child(std::uint32_t parent, std::string_view token) const;
+        std::uint32_t add_child(std::uint32_t parent, std::string_view token);
+        void insert(std::span<const std::uint32_t> parents, const command_info& cmd);
+    };
+}
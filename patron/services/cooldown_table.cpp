@@ -0,0 +1,70 @@
+#include "cooldown_table.h"
+#include <algorithm>
+#include <mutex>
+
+namespace patron
+{
+    std::size_t cooldown_table::bucket_hash::operator()(const bucket_key& key) const noexcept
+    {
+        std::uint64_t hash = reinterpret_cast<std::uintptr_t>(key.key) ^ (key.user * 0x9e3779b97f4a7c15ull);
+        hash ^= hash >> 32;
+        hash *= 0xd6e8feb86659fd93ull;
+        hash ^= hash >> 32;
+        return static_cast<std::size_t>(hash);
+    }
+
+    bool cooldown_table::try_acquire(const void* key, std::uint64_t user, std::uint32_t uses, clock::duration period,
+                                     clock::time_point now)
+    {
+        const bucket_key bucket_key { key, user };
+        const clock::rep now_ticks = now.time_since_epoch().count();
+        const clock::rep period_ticks = period.count();
+        const clock::rep interval = uses ? period_ticks / uses : period_ticks;
+
+        const std::size_t hash = bucket_hash()(bucket_key);
+        shard& shard = m_shards[(hash >> 8) % shard_count];
+        {
+            std::shared_lock lock(shard.mutex);
+            auto it = shard.buckets.find(bucket_key);
+            if (it != shard.buckets.end())
+                return take(it->second, now_ticks, interval, period_ticks);
+        }
+
+        std::unique_lock lock(shard.mutex);
+        if (shard.buckets.size() >= shard.sweep_at)
+        {
+            std::erase_if(shard.buckets, [now_ticks](const auto& entry) {
+                return entry.second.full_at.load(std::memory_order_relaxed) <= now_ticks;
+            });
+            shard.sweep_at = std::max(min_sweep_size, shard.buckets.size() * 2);
+        }
+
+        // a new bucket starts out full, or one was just made by another thread
+        return take(shard.buckets.try_emplace(bucket_key).first->second, now_ticks, interval, period_ticks);
+    }
+
+    std::size_t cooldown_table::size() const
+    {
+        std::size_t size = 0;
+        for (const shard& shard : m_shards)
+        {
+            std::shared_lock lock(shard.mutex);
+            size += shard.buckets.size();
+        }
+        return size;
+    }
+
+    bool cooldown_table::take(bucket& bucket, clock::rep now, clock::rep interval, clock::rep period)
+    {
+        clock::rep full_at = bucket.full_at.load(std::memory_order_relaxed);
+        while (true)
+        {
+            // a bucket can't fill past full, so time it sat full doesn't count
+            const clock::rep next = std::max(full_at, now) + interval;
+            if (next - now > period)
+                return false;
+            if (bucket.full_at.compare_exchange_weak(full_at, next, std::memory_order_relaxed))
+                return true;
+        }
+    }
+}
@@ -0,0 +1,65 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <shared_mutex>
+#include <unordered_map>
+
+namespace patron
+{
+    // the token buckets behind cooldown preconditions, one per key and user. taking from a bucket is a single
+    // compare-and-swap, the map they live in is split into shards so users rarely contend on its locks. a bucket
+    // that has refilled is the same as one that was never made, so those are dropped whenever a shard has doubled
+    // in size since it was last swept, which keeps memory in line with how many users used a command lately.
+    class cooldown_table
+    {
+    public:
+        using clock = std::chrono::steady_clock;
+
+        cooldown_table() = default;
+        cooldown_table(const cooldown_table&) = delete;
+        cooldown_table& operator=(const cooldown_table&) = delete;
+
+        // takes one of the uses the bucket for key and user holds, refilled evenly over period. false if there's
+        // none left.
+        bool try_acquire(const void* key, std::uint64_t user, std::uint32_t uses, clock::duration period,
+                         clock::time_point now = clock::now());
+
+        // how many buckets are held, including ones that have refilled but haven't been swept yet
+        std::size_t size() const;
+    private:
+        static constexpr std::size_t shard_count = 64;
+        static constexpr std::size_t min_sweep_size = 64;
+
+        struct bucket_key
+        {
+            const void* key;
+            std::uint64_t user;
+
+            bool operator==(const bucket_key&) const = default;
+        };
+
+        struct bucket_hash
+        {
+            std::size_t operator()(const bucket_key& key) const noexcept;
+        };
+
+        // the bucket is kept as the time it'll be full again, taking a use pushes that back by period / uses
+        struct bucket
+        {
+            std::atomic<clock::rep> full_at{};
+        };
+
+        struct alignas(64) shard
+        {
+            mutable std::shared_mutex mutex;
+            std::unordered_map<bucket_key, bucket, bucket_hash> buckets;
+            std::size_t sweep_at = min_sweep_size;
+        };
+
+        std::array<shard, shard_count> m_shards;
+
+        static bool take(bucket& bucket, clock::rep now, clock::rep interval, clock::rep period);
+    };
+}
@@ -0,0 +1,162 @@
+#include "executor.h"
+#include <algorithm>
+
+namespace patron
+{
+    namespace
+    {
+        // lets a job posted from a worker land on that worker's own deque
+        thread_local const executor* current_executor = nullptr;
+        thread_local std::size_t current_worker = 0;
+    }
+
+    executor::executor(std::size_t worker_count)
+    {
+        worker_count = std::max<std::size_t>(worker_count, 1);
+        for (std::size_t i = 0; i < worker_count; ++i)
+            m_workers.push_back(std::make_unique<worker>());
+        for (std::size_t i = 0; i < worker_count; ++i)
+            m_threads.emplace_back([this, i] { run(i); });
+    }
+
+    executor::~executor()
+    {
+        {
+            std::lock_guard lock(m_sleep_mutex);
+            m_stopping = true;
+        }
+        m_wake.notify_all();
+        m_threads.clear();
+
+        // a job posted by a thread other than the workers, after they last looked, would otherwise be dropped
+        m_joined.store(true, std::memory_order_release);
+        drain();
+    }
+
+    void executor::drain()
+    {
+        job job;
+        while (try_take(0, job))
+        {
+            job();
+            job = nullptr;
+        }
+    }
+
+    void executor::post(job job)
+    {
+        if (m_joined.load(std::memory_order_acquire))
+        {
+            job();
+            return;
+        }
+
+        const std::size_t index = current_executor == this
+            ? current_worker
+            : m_next.fetch_add(1, std::memory_order_relaxed) % m_workers.size();
+
+        {
+            std::lock_guard lock(m_workers[index]->mutex);
+            m_workers[index]->jobs.push_back(std::move(job));
+        }
+
+        // bumped before taking the sleep mutex, so a worker checking it under the mutex can't miss the wakeup
+        m_pending.fetch_add(1, std::memory_order_release);
+        {
+            std::lock_guard lock(m_sleep_mutex);
+        }
+        m_wake.notify_one();
+    }
+
+    void executor::run(std::size_t index)
+    {
+        current_executor = this;
+        current_worker = index;
+
+        job job;
+        while (true)
+        {
+            if (try_take(index, job))
+            {
+                m_pending.fetch_sub(1, std::memory_order_relaxed);
+                job();
+                job = nullptr;
+                continue;
+            }
+
+            std::unique_lock lock(m_sleep_mutex);
+            m_wake.wait(lock, [this] { return m_pending.load(std::memory_order_acquire) > 0 || m_stopping; });
+            if (m_stopping && m_pending.load(std::memory_order_acquire) == 0)
+                return;
+        }
+    }
+
+    bool executor::try_take(std::size_t index, job& out)
+    {
+        {
+            worker& own = *m_workers[index];
+            std::lock_guard lock(own.mutex);
+            if (!own.jobs.empty())
+            {
+                out = std::move(own.jobs.back());
+                own.jobs.pop_back();
+                return true;
+            }
+        }
+
+        for (std::size_t i = 1; i < m_workers.size(); ++i)
+        {
+            worker& victim = *m_workers[(index + i) % m_workers.size()];
+            std::lock_guard lock(victim.mutex);
+            if (!victim.jobs.empty())
+            {
+                out = std::move(victim.jobs.front());
+                victim.jobs.pop_front();
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    void in_flight_limiter::post(executor& exec, const void* key, executor::job job)
+    {
+        if (m_limit != 0)
+        {
+            std::lock_guard lock(m_mutex);
+            slot& slot = m_slots[key];
+            if (slot.running == m_limit)
+            {
+                slot.waiting.push_back(std::move(job));
+                return;
+            }
+            ++slot.running;
+        }
+
+        exec.post(std::move(job));
+    }
+
+    void in_flight_limiter::release(executor& exec, const void* key)
+    {
+        if (m_limit == 0)
+            return;
+
+        executor::job next;
+        {
+            std::lock_guard lock(m_mutex);
+            auto it = m_slots.find(key);
+            if (it->second.waiting.empty())
+            {
+                if (--it->second.running == 0)
+                    m_slots.erase(it);
+                return;
+            }
+
+            // the finished job's place goes straight to the next one waiting
+            next = std::move(it->second.waiting.front());
+            it->second.waiting.pop_front();
+        }
+
+        exec.post(std::move(next));
+    }
+}
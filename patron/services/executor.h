@@ -0,0 +1,104 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <coroutine>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace patron
+{
+    // a fixed pool of worker threads, each with its own job deque. a worker runs its newest job first and, when
+    // its own deque is empty, steals the oldest job from another worker. jobs posted from a worker go to that
+    // worker's deque, jobs posted from elsewhere are spread round-robin.
+    class executor
+    {
+    public:
+        using job = std::move_only_function<void()>;
+
+        explicit executor(std::size_t worker_count = std::thread::hardware_concurrency());
+
+        // finishes every job already posted, then joins the workers. jobs posted while it's being destroyed, like the
+        // ones an in_flight_limiter lets through as the last running jobs of their key release, still run: on the
+        // destroying thread, or on the posting one once the workers are gone.
+        ~executor();
+
+        executor(const executor&) = delete;
+        executor& operator=(const executor&) = delete;
+
+        // jobs must not throw, wrap them in submit for that
+        void post(job job);
+
+        template<typename F>
+        std::future<std::invoke_result_t<F&>> submit(F fn)
+        {
+            std::packaged_task<std::invoke_result_t<F&>()> task(std::move(fn));
+            std::future<std::invoke_result_t<F&>> future = task.get_future();
+            post(std::move(task));
+            return future;
+        }
+
+        // co_await resumes the awaiting coroutine on one of the workers
+        auto schedule()
+        {
+            struct awaiter
+            {
+                executor& m_executor;
+
+                bool await_ready() const noexcept { return false; }
+                void await_suspend(std::coroutine_handle<> handle) { m_executor.post([handle] { handle.resume(); }); }
+                void await_resume() const noexcept {}
+            };
+            return awaiter { *this };
+        }
+
+        std::size_t worker_count() const { return m_workers.size(); }
+    private:
+        struct worker
+        {
+            std::mutex mutex;
+            std::deque<job> jobs;
+        };
+
+        std::vector<std::unique_ptr<worker>> m_workers;
+        std::vector<std::jthread> m_threads;
+        std::atomic<std::size_t> m_pending;
+        std::atomic<std::size_t> m_next;
+        std::mutex m_sleep_mutex;
+        std::condition_variable m_wake;
+        bool m_stopping{};
+        std::atomic<bool> m_joined;
+
+        void run(std::size_t index);
+        bool try_take(std::size_t index, job& out);
+        void drain();
+    };
+
+    // caps how many jobs sharing a key run at once. jobs over the cap wait here rather than on a worker, so a few
+    // slow commands can't take every worker from the fast ones. a limit of zero means no cap.
+    class in_flight_limiter
+    {
+    public:
+        explicit in_flight_limiter(std::size_t limit) : m_limit(limit) {}
+
+        // posts job to exec now if key is under the limit, otherwise once one of key's running jobs releases.
+        // every job posted must call release for its key when it's done.
+        void post(executor& exec, const void* key, executor::job job);
+        void release(executor& exec, const void* key);
+    private:
+        struct slot
+        {
+            std::size_t running = 0;
+            std::deque<executor::job> waiting;
+        };
+
+        std::size_t m_limit;
+        std::mutex m_mutex;
+        std::unordered_map<const void*, slot> m_slots;
+    };
+}
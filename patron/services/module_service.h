@@ -1,6 +1,8 @@
 #pragma once
 #include "patron/commands/command_execution.h"
 #include "patron/modules/module_base.h"
+#include "command_index.h"
+#include "executor.h"
 
 namespace patron
 {
@@ -15,45 +17,72 @@ namespace patron
             command_result>;
     public:
         explicit module_service(module_service_config config = {})
-            : module_service_base(std::move(config)) {}
+            : module_service_base(std::move(config)),
+              m_snapshot(snapshot { {}, command_index(this->config().case_sensitive_lookup) }),
+              m_in_flight(this->config().max_in_flight_per_command) {}
 
-        std::vector<const module_base*> modules() const
+        // with lazy_modules set, these and search_module's result are the stand-ins holding each module's metadata,
+        // see detail::lazy_module_base
+        std::vector<std::shared_ptr<const module_base>> modules() const
         {
-            std::vector<const module_base*> out;
-            for (const std::unique_ptr<module_base>& module : m_modules)
-                out.push_back(module.get());
-            return out;
+            std::shared_ptr<const snapshot> current = m_snapshot.load();
+            return { current->modules.begin(), current->modules.end() };
         }
 
-        std::vector<const command_info*> search_command(std::string_view name) const
+        command_matches search_command(std::string_view name) const
         {
-            std::vector<const command_info*> out;
-
-            for (const std::unique_ptr<module_base>& module : m_modules)
-                for (const command_info& cmd : module->commands())
-                    if (cmd.matches(name, config().case_sensitive_lookup))
-                        out.push_back(&cmd);
-
-            return out;
+            std::shared_ptr<const snapshot> current = m_snapshot.load();
+            std::span<const command_info* const> matches = current->index.find(name);
+            return command_matches(std::move(current), matches);
         }
 
-        const module_base* search_module(std::string_view name) const
+        std::shared_ptr<const module_base> search_module(std::string_view name) const
         {
-            for (const std::unique_ptr<module_base>& module : m_modules)
+            std::shared_ptr<const snapshot> current = m_snapshot.load();
+            for (const std::shared_ptr<module_base>& module : current->modules)
                 if (module->matches(name, config().case_sensitive_lookup))
-                    return module.get();
+                    return module;
             return nullptr;
         }
 
         template<std::derived_from<module_base> M>
         void register_module()
         {
-            m_modules.push_back(create_module<M>());
+            std::shared_ptr<module_base> module = create_module<M>();
+            m_snapshot.update([&module](snapshot& next) {
+                for (const command_info& cmd : module->commands())
+                    next.index.add(cmd);
+                next.modules.push_back(std::move(module));
+            });
+        }
+
+        // removes every registered module of type M. dispatches already running keep the old snapshot, so the
+        // module is only destroyed once none of them hold it anymore.
+        template<std::derived_from<module_base> M>
+        bool unregister_module()
+        {
+            bool removed = false;
+            m_snapshot.update([this, &removed](snapshot& next) {
+                removed = std::erase_if(next.modules, [](const std::shared_ptr<module_base>& module) {
+                    return typeid(*module) == typeid(M) || typeid(*module) == typeid(detail::lazy_module<M>);
+                }) != 0;
+
+                if (removed)
+                {
+                    next.index = command_index(config().case_sensitive_lookup);
+                    for (const std::shared_ptr<module_base>& module : next.modules)
+                        for (const command_info& cmd : module->commands())
+                            next.index.add(cmd);
+                }
+            });
+            return removed;
         }
 
+        // the namespace's modules are all published in one snapshot, rather than copying it once per module
         template<std::meta::info NS> requires (std::meta::is_namespace(NS))
         void register_namespace()
         {
+            std::vector<std::shared_ptr<module_base>> modules;
             constexpr std::meta::access_context ctx = std::meta::access_context::current();
             template for (constexpr std::meta::info member : define_static_array(std::meta::members_of(NS, ctx)))
             {
@@ -61,57 +90,580 @@ namespace patron
                 {
                     using member_type = [:member:];
                     if constexpr (std::derived_from<member_type, module_base>)
-                        register_module<member_type>();
+                        modules.push_back(create_module<member_type>());
                     else if constexpr (utility::specialization_of<member_type, type_reader>)
                         register_type_reader<member_type>();
+                    else if constexpr (utility::specialization_of<member_type, async_type_reader>)
+                        register_async_type_reader<member_type>();
                 }
             }
+
+            if (modules.empty())
+                return;
+
+            m_snapshot.update([&modules](snapshot& next) {
+                next.modules.reserve(next.modules.size() + modules.size());
+                for (std::shared_ptr<module_base>& module : modules)
+                {
+                    for (const command_info& cmd : module->commands())
+                        next.index.add(cmd);
+                    next.modules.push_back(std::move(module));
+                }
+            });
         }
-    protected:
-        // TODO: provide implementation
-        CoroutineTaskType<command_result> run_command(std::string_view name, std::span<const std::string> args)
-            requires utility::is_awaitable<CoroutineTaskType<command_result>>;
-        command_result run_command(std::string_view name, std::span<const std::string> args)
-            requires (!utility::is_awaitable<CoroutineTaskType<command_result>>);
-    private:
-        std::vector<std::unique_ptr<module_base>> m_modules;
 
-        static consteval std::string build_usage(std::meta::info command)
+        // in coroutine mode each of these is the one frame the library adds to a dispatch. everything up to the
+        // command's own task is started without suspending, then awaited right here, as are the command's async
+        // preconditions and async type readers when it has any. context is who the command is run for.
+        CoroutineTaskType<command_result> run_command(std::string_view message, command_context context = {})
+            requires utility::is_awaitable<CoroutineTaskType<command_result>>
+        {
+            utility::dispatch_arena arena(arena_upstream());
+            utility::tokenizer tokenizer(config().separator_char, arena.resource());
+            if (!tokenize_message(message, tokenizer))
+                co_return command_result::from_error(command_error::unknown_command, "Unknown command");
+
+            // the command can suspend and finish on another thread, so the frame holds its own reference
+            std::shared_ptr<const snapshot> current = m_snapshot.load();
+            overload_state overloads(arena.resource());
+            routed_command routed = route_command(*current, tokenizer.tokens().front(),
+                                                  command_args(tokenizer, 1).with_context(context), overloads);
+            if (std::optional<command_result> unmet = co_await await_preconditions(routed.cmd, std::move(routed.unmet), context))
+                co_return std::move(*unmet);
+
+            async_prefetch prefetch = prefetch_args(routed.cmd, routed.args);
+            co_await prefetch;
+            co_return co_await start_command(routed.cmd, prefetch.args());
+        }
+
+        command_result run_command(std::string_view message, command_context context = {})
+            requires (!utility::is_awaitable<CoroutineTaskType<command_result>>)
+        {
+            utility::dispatch_arena arena(arena_upstream());
+            utility::tokenizer tokenizer(config().separator_char, arena.resource());
+            if (!tokenize_message(message, tokenizer))
+                return command_result::from_error(command_error::unknown_command, "Unknown command");
+            return run_command(tokenizer.tokens().front(), command_args(tokenizer, 1).with_context(context));
+        }
+
+        CoroutineTaskType<command_result> run_command(std::string_view name, std::span<const std::string_view> args,
+                                                      command_context context = {})
+            requires utility::is_awaitable<CoroutineTaskType<command_result>>
+        {
+            utility::dispatch_arena arena(arena_upstream());
+            std::shared_ptr<const snapshot> current = m_snapshot.load();
+            overload_state overloads(arena.resource());
+            routed_command routed = route_command(*current, name, command_args(args, arena.resource()).with_context(context),
+                                                  overloads);
+            if (std::optional<command_result> unmet = co_await await_preconditions(routed.cmd, std::move(routed.unmet), context))
+                co_return std::move(*unmet);
+
+            async_prefetch prefetch = prefetch_args(routed.cmd, routed.args);
+            co_await prefetch;
+            co_return co_await start_command(routed.cmd, prefetch.args());
+        }
+
+        command_result run_command(std::string_view name, std::span<const std::string_view> args,
+                                   command_context context = {})
+            requires (!utility::is_awaitable<CoroutineTaskType<command_result>>)
+        {
+            utility::dispatch_arena arena(arena_upstream());
+            return run_command(name, command_args(args, arena.resource()).with_context(context));
+        }
+
+        CoroutineTaskType<command_result> run_command(std::string_view name, const command_args& args)
+            requires utility::is_awaitable<CoroutineTaskType<command_result>>
+        {
+            std::shared_ptr<const snapshot> current = m_snapshot.load();
+            overload_state overloads(args.resource());
+            routed_command routed = route_command(*current, name, args, overloads);
+            if (std::optional<command_result> unmet = co_await await_preconditions(routed.cmd, std::move(routed.unmet), args.context()))
+                co_return std::move(*unmet);
+
+            async_prefetch prefetch = prefetch_args(routed.cmd, routed.args);
+            co_await prefetch;
+            co_return co_await start_command(routed.cmd, prefetch.args());
+        }
+
+        command_result run_command(std::string_view name, const command_args& args)
+            requires (!utility::is_awaitable<CoroutineTaskType<command_result>>)
+        {
+            snapshot_pin current(*this);
+            overload_state overloads(args.resource());
+            routed_command routed = route_command(*current, name, args, overloads);
+            if (routed.unmet)
+                return std::move(*routed.unmet);
+            if (!routed.cmd)
+                return command_result::from_error(command_error::unknown_command, "Unknown command");
+
+            return invoke_command(routed.cmd, routed.args);
+        }
+
+        // runs a batch of messages, all for context, and gives back their results in order. the whole batch is
+        // tokenized, then looked up, before the first command runs, sharing one arena and one snapshot of the
+        // service. when the service throws, the first exception ends the batch.
+        std::vector<command_result> run_commands(std::span<const std::string_view> messages, command_context context = {})
+            requires (!utility::is_awaitable<CoroutineTaskType<command_result>>)
         {
-            std::string result;
-            for (std::meta::info p : std::meta::parameters_of(command))
+            utility::dispatch_arena arena(arena_upstream());
+            snapshot_pin current(*this);
+            batch batch(*this, *current, messages, arena.resource());
+
+            std::vector<command_result> results;
+            results.reserve(messages.size());
+            for (const batch::entry& entry : batch.entries())
             {
-                if (std::meta::has_default_argument(p))
+                if (entry.matches.empty())
                 {
-                    result += '<';
-                    result += std::meta::identifier_of(p);
-                    result += '>';
+                    results.push_back(command_result::from_error(command_error::unknown_command, "Unknown command"));
+                    continue;
                 }
+
+                overload_state overloads(arena.resource());
+                command_args args = command_args(*entry.tokenizer, entry.depth).with_context(context);
+                resolved_overload resolved = resolve_overload(entry.matches, args, overloads);
+                if (resolved.unmet)
+                    results.push_back(std::move(*resolved.unmet));
                 else
+                    results.push_back(invoke_command(resolved.cmd, args));
+            }
+
+            return results;
+        }
+
+        // the whole batch runs in this one frame, each command awaited before the next starts
+        CoroutineTaskType<std::vector<command_result>> run_commands(std::span<const std::string_view> messages,
+                                                                    command_context context = {})
+            requires utility::is_awaitable<CoroutineTaskType<command_result>>
+        {
+            utility::dispatch_arena arena(arena_upstream());
+            std::shared_ptr<const snapshot> current = m_snapshot.load();
+            batch batch(*this, *current, messages, arena.resource());
+
+            std::vector<command_result> results;
+            results.reserve(messages.size());
+            for (const batch::entry& entry : batch.entries())
+            {
+                if (entry.matches.empty())
                 {
-                    result += '[';
-                    result += std::meta::identifier_of(p);
-                    result += ']';
+                    results.push_back(command_result::from_error(command_error::unknown_command, "Unknown command"));
+                    continue;
                 }
-                result += ' ';
+
+                overload_state overloads(arena.resource());
+                command_args args = command_args(*entry.tokenizer, entry.depth).with_context(context);
+                resolved_overload resolved = resolve_overload(entry.matches, args, overloads);
+                if (std::optional<command_result> unmet = co_await await_preconditions(resolved.cmd, std::move(resolved.unmet), context))
+                {
+                    results.push_back(std::move(*unmet));
+                    continue;
+                }
+
+                async_prefetch prefetch = prefetch_args(resolved.cmd, args);
+                co_await prefetch;
+                results.push_back(co_await start_command(resolved.cmd, prefetch.args()));
             }
 
-            if (!result.empty())
-                result.pop_back();
+            co_return results;
+        }
+
+        // runs the message on one of exec's workers instead of the calling thread. dispatches of the same command
+        // beyond max_in_flight_per_command wait their turn without taking up a worker.
+        std::future<command_result> submit_command(executor& exec, std::string message, command_context context = {})
+            requires (!utility::is_awaitable<CoroutineTaskType<command_result>>)
+        {
+            const void* key = in_flight_key(message);
+            std::packaged_task<command_result()> task([this, message = std::move(message), context] {
+                return run_command(message, context);
+            });
+            std::future<command_result> future = task.get_future();
+
+            m_in_flight.post(exec, key, [this, &exec, key, task = std::move(task)] mutable {
+                task();
+                m_in_flight.release(exec, key);
+            });
+            return future;
+        }
+
+        CoroutineTaskType<command_result> submit_command(executor& exec, std::string message, command_context context = {})
+            requires utility::is_awaitable<CoroutineTaskType<command_result>>
+        {
+            struct awaiter
+            {
+                in_flight_limiter& m_limiter;
+                executor& m_executor;
+                const void* m_key;
+
+                bool await_ready() const noexcept { return false; }
+                void await_suspend(std::coroutine_handle<> handle)
+                {
+                    m_limiter.post(m_executor, m_key, [handle] { handle.resume(); });
+                }
+                void await_resume() const noexcept {}
+            };
+
+            struct release_guard
+            {
+                in_flight_limiter& m_limiter;
+                executor& m_executor;
+                const void* m_key;
+
+                ~release_guard() { m_limiter.release(m_executor, m_key); }
+            };
+
+            const void* key = in_flight_key(message);
+            co_await awaiter { m_in_flight, exec, key };
+            release_guard guard { m_in_flight, exec, key };
+            co_return co_await run_command(message, context);
+        }
+
+        // a thread also keeps the snapshot its last sync dispatch used, and with it any modules unregistered since,
+        // until it dispatches again. this drops that too. it does nothing when called from inside a dispatch.
+        void release_thread_state() const override
+        {
+            dispatch_state& state = this->template thread_state<dispatch_state>();
+            if (state.depth != 0)
+                return;
+
+            state.reader.release();
+            module_service_base::release_thread_state();
+        }
+    private:
+        struct snapshot
+        {
+            std::vector<std::shared_ptr<module_base>> modules;
+            command_index index;
+        };
+
+        struct dispatch_state
+        {
+            utility::snapshot_reader<snapshot> reader;
+            std::size_t depth = 0;
+        };
+
+        // the tokenize and lookup passes of run_commands, done for every message before any command runs
+        class batch
+        {
+        public:
+            struct entry
+            {
+                utility::tokenizer* tokenizer;
+                // the overloads at the message's path, empty when there's no command there
+                std::span<const command_info* const> matches;
+                // how many tokens the command's groups and name take up
+                std::size_t depth = 1;
+            };
+
+            batch(const module_service& service, const snapshot& current, std::span<const std::string_view> messages,
+                  std::pmr::memory_resource* resource)
+                : m_allocator(resource), m_entries(resource)
+            {
+                m_entries.reserve(messages.size());
+                for (std::string_view message : messages)
+                {
+                    // a message without the prefix is left with no tokens, like one with nothing after it
+                    entry& entry = m_entries.emplace_back(
+                        m_allocator.new_object<utility::tokenizer>(service.config().separator_char, resource));
+                    service.tokenize_message(message, *entry.tokenizer);
+                }
+
+                for (entry& entry : m_entries)
+                {
+                    if (entry.tokenizer->tokens().empty())
+                        continue;
+
+                    std::span<const std::string_view> tokens = entry.tokenizer->tokens();
+                    command_route route = current.index.route(tokens.front(), tokens.subspan(1));
+                    entry.matches = route.matches;
+                    entry.depth = 1 + route.consumed;
+                }
+            }
+
+            batch(const batch&) = delete;
+            batch& operator=(const batch&) = delete;
+
+            ~batch()
+            {
+                for (entry& entry : m_entries)
+                    m_allocator.delete_object(entry.tokenizer);
+            }
+
+            std::span<const entry> entries() const { return m_entries; }
+        private:
+            std::pmr::polymorphic_allocator<> m_allocator;
+            std::pmr::vector<entry> m_entries;
+        };
+
+        // the calling thread's cached snapshot, refreshed only by the outermost dispatch on the thread so a command
+        // that runs another command can't free the snapshot its caller is still using. it's kept between dispatches,
+        // so one only touches the shared reference count when something was registered since the last, see
+        // release_thread_state.
+        class snapshot_pin
+        {
+        public:
+            explicit snapshot_pin(const module_service& service)
+                : m_state(service.template thread_state<dispatch_state>())
+            {
+                if (m_state.depth++ == 0)
+                    m_state.reader.refresh(service.m_snapshot);
+            }
+
+            snapshot_pin(const snapshot_pin&) = delete;
+            snapshot_pin& operator=(const snapshot_pin&) = delete;
+            ~snapshot_pin() { --m_state.depth; }
+
+            const snapshot& operator*() const { return m_state.reader.get(); }
+            const snapshot* operator->() const { return &m_state.reader.get(); }
+        private:
+            dispatch_state& m_state;
+        };
+
+        utility::snapshot_cell<snapshot> m_snapshot;
+        in_flight_limiter m_in_flight;
+
+        // the command resolve_overload picked, whose sync preconditions have been checked. unmet is what to report
+        // instead when they weren't met, cmd is null when that's true of every candidate or resolving threw.
+        struct resolved_overload
+        {
+            const command_info* cmd;
+            std::optional<command_result> unmet;
+        };
+
+        // a command found by routing and the arguments left after its groups and name
+        struct routed_command
+        {
+            const command_info* cmd;
+            command_args args;
+            std::optional<command_result> unmet;
+        };
+
+        // what resolving an overload converted, which the command it picks is then run with. it has to outlive
+        // the dispatch's use of the args resolve_overload gives back.
+        struct overload_state
+        {
+            detail::conversion_cache cache;
+            std::pmr::vector<prefetched_arg> prefetched;
+
+            explicit overload_state(std::pmr::memory_resource* resource)
+                : cache(resource), prefetched(resource) {}
+        };
+
+        // name is the first token of the path, args everything after it. cmd is null when no path matched.
+        routed_command route_command(const snapshot& current, std::string_view name, const command_args& args,
+                                     overload_state& overloads)
+        {
+            command_route route = current.index.route(name, args.values());
+            if (route.matches.empty())
+                return { nullptr, args };
+
+            command_args rest = args.drop_front(route.consumed);
+            resolved_overload resolved = resolve_overload(route.matches, rest, overloads);
+            return { resolved.cmd, rest, std::move(resolved.unmet) };
+        }
+
+        // readers and preconditions run here, before the command starts, so what they throw is reported the same
+        // way command_function::start reports what the command throws
+        resolved_overload resolve_overload(std::span<const command_info* const> candidates, command_args& args,
+                                           overload_state& overloads)
+        {
+        #if __cpp_exceptions
+            if (!config().throw_exceptions)
+            {
+                try
+                {
+                    return pick_overload(candidates, args, overloads);
+                }
+                catch (const bad_command_argument& e)
+                {
+                    return { nullptr, command_result::from_error(e) };
+                }
+                catch (const std::exception& e)
+                {
+                    return { nullptr, command_result::from_error(e) };
+                }
+            }
+        #endif
+
+            return pick_overload(candidates, args, overloads);
+        }
+
+        // with more than one command at the path, converts the arguments for each and picks the one whose
+        // conversions weigh the most, the first declared on a tie. candidates that can't take this many
+        // arguments are passed over without converting anything, and so are those whose static preconditions
+        // aren't met, which are checked first. only the command picked takes a use of its cooldowns. conversions
+        // are shared between the rest through the cache, and args is pointed at the winner's converted values, so
+        // they aren't converted again. when no candidate converts, the first that could take the arguments is
+        // picked to report why, and when none met their preconditions, the first that didn't is reported.
+        resolved_overload pick_overload(std::span<const command_info* const> candidates, command_args& args,
+                                        overload_state& overloads)
+        {
+            if (candidates.size() == 1)
+                return { candidates.front(), candidates.front()->function().check_preconditions(args.context(), this) };
+
+            std::optional<command_result> unmet;
+            const command_info* fallback = nullptr;
+            const command_info* best = nullptr;
+            float best_score = 0.0f;
+            for (const command_info* cmd : candidates)
+            {
+                const command_function& function = cmd->function();
+                if (args.size() < function.target_arg_count() ||
+                    (!cmd->m_data.m_ignore_extra_args && args.size() < function.reader_slots().size()))
+                    continue;
+
+                if (std::optional<command_result> failed = function.check_static_preconditions(args.context(), this))
+                {
+                    if (!unmet)
+                        unmet = std::move(failed);
+                    continue;
+                }
+
+                if (!fallback)
+                    fallback = cmd;
+                if (std::optional<float> score = function.score(args, overloads.cache, this); score && (!best || *score > best_score))
+                {
+                    best = cmd;
+                    best_score = *score;
+                }
+            }
+
+            if (!best)
+            {
+                if (fallback)
+                    return { fallback, fallback->function().acquire_cooldowns(args.context(), this) };
+                if (unmet)
+                    return { nullptr, std::move(unmet) };
+                // none could take the arguments, the first reports that once its preconditions are met
+                return { candidates.front(), candidates.front()->function().check_preconditions(args.context(), this) };
+            }
+
+            std::span<const command_function::reader_slot_fn> slots = best->function().reader_slots();
+            overloads.prefetched.assign(args.size(), prefetched_arg { nullptr, nullptr });
+            for (std::size_t i = 0; i < std::min(slots.size(), args.size()); ++i)
+            {
+                if (!slots[i])
+                    continue;
+
+                const detail::conversion_cache::conversion* conversion = overloads.cache.find(slots[i](), i);
+                if (conversion && conversion->value)
+                    overloads.prefetched[i] = { conversion->value, detail::conversion_cache::converted() };
+            }
+
+            args = args.with_prefetched(overloads.prefetched);
+            return { best, best->function().acquire_cooldowns(args.context(), this) };
+        }
+
+        // runs a command resolve_overload picked, which has already checked its preconditions
+        command_result invoke_command(const command_info* cmd, const command_args& args)
+            requires (!utility::is_awaitable<CoroutineTaskType<command_result>>)
+        {
+            expected_result<command_result> result = cmd->function().template start<command_result>(
+                cmd->name(), config().throw_exceptions, cmd->instance(), args, this);
+            return result ? std::move(*result) : std::move(result.error());
+        }
+
+        // reports cmd's unmet sync preconditions, or runs its async ones in the dispatch's frame. those only get a
+        // coroutine of their own for commands that have some.
+        class precondition_awaiter
+        {
+        public:
+            explicit precondition_awaiter(std::optional<command_result> unmet)
+                : m_unmet(std::move(unmet)) {}
+
+            precondition_awaiter(CoroutineTaskType<command_result> async, bool exceptions)
+            {
+                m_async.emplace(std::move(async), exceptions);
+            }
+
+            bool await_ready() { return !m_async || m_async->await_ready(); }
+
+            template<typename Promise>
+            decltype(auto) await_suspend(std::coroutine_handle<Promise> handle) { return m_async->await_suspend(handle); }
+
+            std::optional<command_result> await_resume()
+            {
+                if (m_async)
+                {
+                    if (command_result met = m_async->await_resume(); !met.success())
+                        return met;
+                    return std::nullopt;
+                }
+                return std::move(m_unmet);
+            }
+        private:
+            std::optional<command_result> m_unmet;
+            std::optional<started_command<CoroutineTaskType<command_result>>> m_async;
+        };
+
+        // unmet is what resolve_overload gave back for cmd, having checked its sync preconditions already
+        precondition_awaiter await_preconditions(const command_info* cmd, std::optional<command_result> unmet,
+                                                 const command_context& context)
+            requires utility::is_awaitable<CoroutineTaskType<command_result>>
+        {
+            if (unmet || !cmd)
+                return precondition_awaiter(std::move(unmet));
+
+            const command_function& function = cmd->function();
+            if (!function.has_async_preconditions())
+                return precondition_awaiter(std::nullopt);
+
+            return precondition_awaiter(function.template check_async_preconditions<CoroutineTaskType>(context),
+                                        config().throw_exceptions);
+        }
+
+        // async type readers only run here, in coroutine mode, where the dispatch can wait on them
+        async_prefetch prefetch_args(const command_info* cmd, const command_args& args) const
+            requires utility::is_awaitable<CoroutineTaskType<command_result>>
+        {
+            return async_prefetch(*this, cmd ? cmd->function().reader_slots() : std::span<const command_function::reader_slot_fn>(),
+                                  args);
+        }
+
+        // cmd is null when there's no command called name
+        started_command<CoroutineTaskType<command_result>> start_command(const command_info* cmd, const command_args& args)
+            requires utility::is_awaitable<CoroutineTaskType<command_result>>
+        {
+            if (!cmd)
+                return { std::unexpected(command_result::from_error(command_error::unknown_command, "Unknown command")),
+                         config().throw_exceptions };
+
+            return { cmd->function().template start<CoroutineTaskType<command_result>>(
+                         cmd->name(), config().throw_exceptions, cmd->instance(), args, this),
+                     config().throw_exceptions };
+        }
+
+        // in-flight limits are per command, aliases included, so the key is the command the message would run
+        const void* in_flight_key(std::string_view message) const
+        {
+            if (config().max_in_flight_per_command == 0)
+                return nullptr;
+
+            utility::tokenizer tokenizer(config().separator_char);
+            if (!tokenize_message(message, tokenizer))
+                return nullptr;
 
-            return result;
+            std::shared_ptr<const snapshot> current = m_snapshot.load();
+            std::span<const std::string_view> tokens = tokenizer.tokens();
+            command_route route = current->index.route(tokens.front(), tokens.subspan(1));
+            return route.matches.empty() ? nullptr : route.matches.front();
         }
 
         template<std::derived_from<module_base> M>
-        std::unique_ptr<M> create_module()
+        std::shared_ptr<module_base> create_module()
         {
             constexpr module_base::module_data module_data(
                 std::meta::identifier_of(^^M),
                 utility::find_annotation(^^M, ^^summary),
                 utility::find_annotation(^^M, ^^remarks),
                 utility::find_annotation(^^M, ^^alias));
+            constexpr std::optional<std::meta::info> module_group = utility::find_annotation(^^M, ^^group);
 
-            std::unique_ptr<M> module = std::make_unique<M>();
+            const bool lazy = config().lazy_modules;
+            std::shared_ptr<module_base> module;
+            if (lazy)
+                module = std::make_shared<detail::lazy_module<M>>();
+            else
+                module = std::make_shared<M>();
             module->m_data = module_data;
 
             constexpr std::meta::access_context ctx = std::meta::access_context::current();
@@ -128,12 +680,13 @@ namespace patron
                             utility::find_annotation(member, ^^summary),
                             utility::find_annotation(member, ^^remarks),
                             utility::find_annotation(member, ^^alias),
-                            build_usage(member));
+                            command_execution::build_usage(member),
+                            module_group,
+                            utility::find_annotation(member, ^^group));
                         command_function cmd_fn = command_execution::create_command_function
-                            <member, utility::static_span<const std::meta::info>(std::meta::parameters_of(member)), M>
-                            (cmd_data.m_name, cmd_data.m_ignore_extra_args, cmd_data.m_remainder);
+                            <member, utility::static_span<const std::meta::info>(std::meta::parameters_of(member)), M, command_result_t>();
 
-                        module->m_commands.emplace_back(cmd_data, module.get(), std::move(cmd_fn));
+                        module->m_commands.emplace_back(cmd_data, module.get(), std::move(cmd_fn), lazy);
                     }
                 }
             }
@@ -1,54 +1,363 @@
 #pragma once
-#include "patron/commands/type_reader.h"
+#include "patron/commands/async_type_reader.h"
+#include "patron/commands/command_function.h"
 #include "patron/utils/concepts.h"
+#include "patron/utils/dispatch_arena.h"
+#include "patron/utils/snapshot.h"
 #include "patron/utils/strings.h"
-#include <functional>
-#include <typeindex>
-#include <unordered_map>
+#include "patron/utils/tokenizer.h"
+#include "cooldown_table.h"
+#include <algorithm>
+#include <atomic>
+#include <memory>
 
 namespace patron
 {
+    namespace detail
+    {
+        inline std::size_t next_type_reader_slot()
+        {
+            static std::atomic<std::size_t> next_slot;
+            return next_slot.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        // a dense index per type, so finding a type's reader is a vector lookup rather than hashing its type_info
+        template<typename T>
+        std::size_t type_reader_slot()
+        {
+            static const std::size_t slot = next_type_reader_slot();
+            return slot;
+        }
+
+        // never reused, unlike a service's address, so state cached for a destroyed service can't be mistaken for
+        // a new one's
+        inline std::uint64_t next_service_id()
+        {
+            static std::atomic<std::uint64_t> next_id { 1 };
+            return next_id.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
     struct module_service_config
     {
         bool case_sensitive_lookup{};
         char command_prefix = '!';
         char separator_char = ' ';
         bool throw_exceptions{};
+        // where the arena each dispatch makes for its temporaries gets memory once its inline buffer runs out.
+        // it's called once per dispatch, so it can hand back a thread-local pool. defaults to the default resource.
+        std::pmr::memory_resource* (*arena_upstream)() = nullptr;
+        // how many dispatches of one command submit_command lets run at once, the rest wait without holding a
+        // worker. zero means no limit.
+        std::size_t max_in_flight_per_command{};
+        // with this set, module_service only builds a module's metadata and commands when it's registered. the
+        // module itself is constructed the first time one of its commands is dispatched. until then what
+        // modules() and search_module() hand back is a stand-in with the same metadata and commands, but it isn't
+        // the module's own type, so a dynamic_cast to it fails. detail::lazy_module_base::instance() gets the
+        // module, constructing it if it has to be.
+        bool lazy_modules{};
     };
 
+    // any number of threads can dispatch at once, and modules, type readers and extra data can be registered
+    // while they do. registering publishes a new snapshot of what it changes: dispatches already running keep the
+    // snapshot they started with, and lookup never takes a lock. every dispatch has its own tokenizer and arena,
+    // and type readers are instantiated per thread. modules are still shared between threads, so their commands
+    // need to be safe to run concurrently.
     class module_service_base
     {
     public:
         explicit module_service_base(module_service_config config = {})
             : m_config(std::move(config)) {}
 
+        virtual ~module_service_base() = default;
+
+        module_service_base(const module_service_base&) = delete;
+        module_service_base& operator=(const module_service_base&) = delete;
+
         const module_service_config& config() const { return m_config; }
 
+        // where cooldown preconditions keep track of their uses
+        cooldown_table& cooldowns() const { return m_cooldowns; }
+
+        // each thread keeps one instance of each type reader, created and injected with extra data the first time
+        // it's needed there, then reset and handed out again for every read on that thread after that
         template<typename T>
-        std::unique_ptr<type_reader_base<T>> create_type_reader() const
+        type_reader_base<T>* get_type_reader() const
         {
-            if (auto it = m_type_reader_factories.find(typeid(T)); it != m_type_reader_factories.end())
-                return std::unique_ptr<type_reader_base<T>>(static_cast<type_reader_base<T>*>(it->second()));
-            return nullptr;
+            const std::size_t slot = detail::type_reader_slot<T>();
+            thread_readers& readers = thread_state<thread_readers>();
+            const type_reader_registry& registry = refresh_registry(readers);
+            if (slot >= registry.factories.size() || !registry.factories[slot])
+                return nullptr;
+
+            if (slot >= readers.instances.size())
+                readers.instances.resize(slot + 1);
+            if (!readers.instances[slot])
+                readers.instances[slot].reset(registry.factories[slot](registry.extra_data));
+
+            type_reader_base<T>* reader = static_cast<type_reader_base<T>*>(readers.instances[slot].get());
+            reader->reset();
+            return reader;
+        }
+
+        // async readers are shared by every thread instead, and created when they're registered
+        template<typename T>
+        std::shared_ptr<async_type_reader_base<T>> get_async_type_reader() const
+        {
+            return std::static_pointer_cast<async_type_reader_base<T>>(find_async_type_reader(detail::type_reader_slot<T>()));
+        }
+
+        // a thread keeps what it cached for the service, like the registry its type readers came from and the
+        // readers themselves, until something newer is registered. this drops it, for a thread that's done
+        // dispatching for a while, like a worker going idle. it mustn't be called from inside a dispatch.
+        virtual void release_thread_state() const
+        {
+            thread_readers& readers = thread_state<thread_readers>();
+            readers.instances.clear();
+            readers.registry_ptr = nullptr;
+            readers.registry.release();
         }
 
         template<typename T>
         void register_extra_data(T&& data = {})
         {
-            m_extra_data.emplace_back(std::forward<T>(data));
+            // existing readers were injected without this, the new snapshot has every thread recreate them. async
+            // readers are recreated here, the old ones still send and complete whatever reads they already have.
+            m_type_readers.update([&data](type_reader_registry& registry) {
+                registry.extra_data.emplace_back(std::forward<T>(data));
+                for (std::size_t i = 0; i < registry.async_factories.size(); ++i)
+                    if (registry.async_factories[i])
+                        registry.async_readers[i] = registry.async_factories[i](registry.extra_data);
+            });
         }
 
         template<utility::specialization_of<type_reader> T>
         void register_type_reader()
         {
-            const std::type_info& info = typeid(typename T::value_type);
-            auto [_, success] = m_type_reader_factories.try_emplace(info, [this] -> void* { return T::create(m_extra_data); });
-            if (!success)
-                throw std::logic_error("A type reader has already been registered for " + utility::demangle(info.name()));
+            using value_type = typename T::value_type;
+
+            const std::size_t slot = detail::type_reader_slot<value_type>();
+            m_type_readers.update([slot](type_reader_registry& registry) {
+                registry.check_unregistered<value_type>(slot);
+                if (slot >= registry.factories.size())
+                    registry.factories.resize(slot + 1);
+
+                registry.factories[slot] = [](std::span<const std::any> extra_data) -> detail::type_reader_erased* {
+                    return T::create(extra_data);
+                };
+            });
+        }
+
+        template<utility::specialization_of<async_type_reader> T>
+        void register_async_type_reader()
+        {
+            using value_type = typename T::value_type;
+
+            const std::size_t slot = detail::type_reader_slot<value_type>();
+            m_type_readers.update([slot](type_reader_registry& registry) {
+                registry.check_unregistered<value_type>(slot);
+                if (slot >= registry.async_factories.size())
+                {
+                    registry.async_factories.resize(slot + 1);
+                    registry.async_readers.resize(slot + 1);
+                }
+
+                registry.async_factories[slot] = [](std::span<const std::any> extra_data)
+                    -> std::shared_ptr<detail::async_type_reader_erased> {
+                    return T::create(extra_data);
+                };
+                registry.async_readers[slot] = registry.async_factories[slot](registry.extra_data);
+            });
+        }
+    protected:
+        std::pmr::memory_resource* arena_upstream() const
+        {
+            return m_config.arena_upstream ? m_config.arena_upstream() : std::pmr::get_default_resource();
+        }
+
+        // state the calling thread keeps for this service, created on first use. a thread drops the state of
+        // destroyed services when it next creates some, so that's when their snapshots held there are freed. the
+        // service asked for last is remembered, which on most threads is the only one, so finding its state again
+        // is a compare.
+        template<typename State>
+        State& thread_state() const
+        {
+            struct entry
+            {
+                std::uint64_t owner;
+                std::weak_ptr<const void> alive;
+                std::unique_ptr<State> state;
+            };
+
+            thread_local std::uint64_t last_owner = 0;
+            thread_local State* last_state = nullptr;
+            if (last_owner == m_id)
+                return *last_state;
+
+            thread_local std::vector<entry> entries;
+            auto it = std::ranges::find(entries, m_id, &entry::owner);
+            if (it == entries.end())
+            {
+                std::erase_if(entries, [](const entry& entry) { return entry.alive.expired(); });
+                it = entries.insert(entries.end(), entry { m_id, m_alive, std::make_unique<State>() });
+            }
+
+            last_owner = m_id;
+            last_state = it->state.get();
+            return *last_state;
+        }
+
+        // checks the message starts with the command prefix, then splits the rest of it into the command name
+        // followed by its arguments
+        bool tokenize_message(std::string_view message, utility::tokenizer& tokenizer) const
+        {
+            if (!message.starts_with(m_config.command_prefix))
+                return false;
+            tokenizer.tokenize(message.substr(1));
+            return !tokenizer.tokens().empty();
         }
+        class async_prefetch;
     private:
+        using type_reader_factory = detail::type_reader_erased* (*)(std::span<const std::any>);
+        using async_type_reader_factory = std::shared_ptr<detail::async_type_reader_erased> (*)(std::span<const std::any>);
+
+        struct type_reader_registry
+        {
+            std::vector<std::any> extra_data;
+            std::vector<type_reader_factory> factories;
+            std::vector<async_type_reader_factory> async_factories;
+            std::vector<std::shared_ptr<detail::async_type_reader_erased>> async_readers;
+
+            // a type is read by one reader, sync or async
+            template<typename T>
+            void check_unregistered(std::size_t slot) const
+            {
+                if ((slot < factories.size() && factories[slot]) || (slot < async_factories.size() && async_factories[slot]))
+                    utility::throw_exception(std::logic_error("A type reader has already been registered for " + utility::demangle(typeid(T).name())));
+            }
+        };
+
+        struct thread_readers
+        {
+            utility::snapshot_reader<type_reader_registry> registry;
+            const type_reader_registry* registry_ptr = nullptr;
+            std::vector<std::unique_ptr<detail::type_reader_erased>> instances;
+        };
+
+        const type_reader_registry& refresh_registry(thread_readers& readers) const
+        {
+            const type_reader_registry* previous = readers.registry_ptr;
+            const type_reader_registry& registry = readers.registry.refresh(m_type_readers);
+            if (&registry != previous)
+            {
+                // a reader or extra data was registered since this thread last looked, start over
+                readers.instances.clear();
+                readers.registry_ptr = &registry;
+            }
+            return registry;
+        }
+
+        std::shared_ptr<detail::async_type_reader_erased> find_async_type_reader(std::size_t slot) const
+        {
+            const type_reader_registry& registry = refresh_registry(thread_state<thread_readers>());
+            return slot < registry.async_readers.size() ? registry.async_readers[slot] : nullptr;
+        }
+
         module_service_config m_config;
-        std::vector<std::any> m_extra_data;
-        std::unordered_map<std::type_index, std::function<void*()>> m_type_reader_factories;
+        utility::snapshot_cell<type_reader_registry> m_type_readers;
+        mutable cooldown_table m_cooldowns;
+        // only watched through weak references, so threads can tell when this service is gone
+        std::shared_ptr<const void> m_alive = std::make_shared<const char>();
+        std::uint64_t m_id = detail::next_service_id();
+    };
+
+    // reads a command's arguments that have an async type reader before the command is started. the reads are all
+    // started at once and awaited together, so a command taking several entities waits on the slowest lookup
+    // rather than their sum. awaiting it suspends until the last one is done, args() then hands them to the
+    // conversion along with the text they were read from. that still goes in order, so a failed read is reported
+    // with its argument's index, unless an earlier argument failed first. it's awaited in the dispatch's own
+    // frame, so it can't be moved.
+    class module_service_base::async_prefetch
+    {
+    public:
+        async_prefetch(const module_service_base& service, std::span<const command_function::reader_slot_fn> reader_slots,
+                       const command_args& args)
+            : m_args(args), m_reads(args.resource()), m_prefetched(args.resource())
+        {
+            if (reader_slots.empty())
+                return;
+
+            const type_reader_registry& registry = service.refresh_registry(service.thread_state<thread_readers>());
+            if (registry.async_readers.empty())
+                return;
+
+            for (std::size_t i = 0; i < std::min(reader_slots.size(), args.size()); ++i)
+            {
+                if (!reader_slots[i] || args[i].empty() || args.prefetched(i))
+                    continue;
+
+                const std::size_t slot = reader_slots[i]();
+                if (slot < registry.async_readers.size() && registry.async_readers[slot])
+                    m_reads.push_back({ registry.async_readers[slot], i, {} });
+            }
+        }
+
+        async_prefetch(const async_prefetch&) = delete;
+        async_prefetch& operator=(const async_prefetch&) = delete;
+
+        bool await_ready() const noexcept { return m_reads.empty(); }
+
+        // the reads may finish, and the dispatch resume, while they're still being started. the extra count held
+        // until the last one is started keeps that from happening under this loop, and if they're all done by
+        // then, the dispatch just carries on.
+        bool await_suspend(std::coroutine_handle<> handle)
+        {
+            m_handle = handle;
+            m_remaining.store(m_reads.size() + 1, std::memory_order_relaxed);
+            for (auto it = m_reads.begin(); it != m_reads.end(); ++it)
+            {
+                const bool last = std::none_of(it + 1, m_reads.end(), [&](const pending& later) { return later.reader == it->reader; });
+                it->reader->enqueue(m_args[it->index], { &it->read, &on_read, this }, last);
+            }
+            return m_remaining.fetch_sub(1, std::memory_order_acq_rel) != 1;
+        }
+
+        void await_resume()
+        {
+            if (m_reads.empty())
+                return;
+
+            // keeping whatever the args already had, like values converted while resolving an overload
+            m_prefetched.resize(m_args.size(), prefetched_arg { nullptr, nullptr });
+            for (std::size_t i = 0; i < m_args.size(); ++i)
+                if (const prefetched_arg* prefetched = m_args.prefetched(i))
+                    m_prefetched[i] = *prefetched;
+            for (const pending& read : m_reads)
+                m_prefetched[read.index] = { read.read.value(), &read.read.result() };
+        }
+
+        command_args args() const { return m_prefetched.empty() ? m_args : m_args.with_prefetched(m_prefetched); }
+    private:
+        struct pending
+        {
+            // held so the reader outlives the read, even if it's replaced meanwhile
+            std::shared_ptr<detail::async_type_reader_erased> reader;
+            std::size_t index;
+            detail::async_read read;
+        };
+
+        command_args m_args;
+        std::pmr::vector<pending> m_reads;
+        std::pmr::vector<prefetched_arg> m_prefetched;
+        std::atomic<std::size_t> m_remaining;
+        std::coroutine_handle<> m_handle;
+
+        // reads finish on whichever thread completes their batch, the last one resumes the dispatch
+        static void on_read(void* context)
+        {
+            async_prefetch& self = *static_cast<async_prefetch*>(context);
+            if (self.m_remaining.fetch_sub(1, std::memory_order_acq_rel) == 1)
+                self.m_handle.resume();
+        }
     };
 }
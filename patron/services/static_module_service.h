@@ -0,0 +1,333 @@
+#pragma once
+#include "patron/commands/command_execution.h"
+#include "patron/modules/module_base.h"
+#include "patron/utils/case_fold.h"
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <numeric>
+#include <tuple>
+#include <vector>
+
+namespace patron
+{
+    namespace detail
+    {
+        // keys are hashed case-folded no matter the config, so the same table serves both lookup modes
+        constexpr std::size_t static_lookup_hash(std::string_view str)
+        {
+            std::size_t hash = 14695981039346656037ull;
+            utility::for_each_folded_byte(str, [&hash](char c) {
+                hash ^= static_cast<unsigned char>(c);
+                hash *= 1099511628211ull;
+            });
+            return hash;
+        }
+
+        template<typename... Modules>
+        struct static_command_table
+        {
+            static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+            struct lookup_slot
+            {
+                std::string_view key;
+                std::size_t ordinal = npos;
+                // another key differs from this one only in case
+                bool shared = false;
+            };
+
+            static constexpr std::span<const std::meta::info> commands = define_static_array([] consteval {
+                std::vector<std::meta::info> out;
+
+                constexpr std::meta::access_context ctx = std::meta::access_context::current();
+                for (std::meta::info module : {^^Modules...})
+                    for (std::meta::info member : std::meta::members_of(module, ctx))
+                        if (std::meta::is_function(member) && utility::find_annotation(member, ^^command).has_value())
+                            out.push_back(member);
+
+                return out;
+            }());
+
+            static constexpr std::array<command_info::command_data, commands.size()> data =
+                []<std::size_t... Is>(std::index_sequence<Is...>) consteval {
+                    return std::array<command_info::command_data, sizeof...(Is)> {
+                        command_info::command_data(
+                            utility::find_annotation(commands[Is], ^^command).value(),
+                            utility::find_annotation(commands[Is], ^^summary),
+                            utility::find_annotation(commands[Is], ^^remarks),
+                            utility::find_annotation(commands[Is], ^^alias),
+                            command_execution::build_usage(commands[Is]),
+                            utility::find_annotation(std::meta::parent_of(commands[Is]), ^^group),
+                            utility::find_annotation(commands[Is], ^^group))...
+                    };
+                }(std::make_index_sequence<commands.size()>());
+
+            // the lookup table below only matches single names
+            static_assert(std::ranges::none_of(data, [](const command_info::command_data& cmd) { return !cmd.m_groups.empty(); }),
+                          "Command groups need a module_service");
+
+            static constexpr std::array<std::size_t, commands.size()> target_arg_counts =
+                []<std::size_t... Is>(std::index_sequence<Is...>) consteval {
+                    return std::array<std::size_t, sizeof...(Is)> {
+                        command_execution::target_arg_count(
+                            utility::static_span<const std::meta::info>(std::meta::parameters_of(commands[Is])))...
+                    };
+                }(std::make_index_sequence<commands.size()>());
+
+            // checking preconditions is skipped altogether when no command has any
+            static constexpr bool has_preconditions = [] consteval {
+                bool any = false;
+                template for (constexpr std::meta::info fn : commands)
+                    any = any || command_execution::has_sync_preconditions<fn, typename[:std::meta::parent_of(fn):]>();
+                return any;
+            }();
+
+            static constexpr std::array<std::size_t, commands.size()> ordinals = [] consteval {
+                std::array<std::size_t, commands.size()> out;
+                std::iota(out.begin(), out.end(), 0);
+                return out;
+            }();
+
+            // with no overloads to route between, a name or alias used twice would leave one of the commands unreachable
+            static_assert([] consteval {
+                std::vector<std::string_view> keys;
+                for (const command_info::command_data& cmd : data)
+                {
+                    keys.push_back(cmd.m_name);
+                    keys.append_range(cmd.m_aliases);
+                }
+
+                std::ranges::sort(keys);
+                return std::ranges::adjacent_find(keys) == keys.end();
+            }(), "Command names and aliases have to be unique, use a module_service for overloads");
+
+            static constexpr std::size_t lookup_size = std::bit_ceil([] consteval {
+                std::size_t count = 0;
+                for (const command_info::command_data& cmd : data)
+                    count += 1 + cmd.m_aliases.size();
+                return count;
+            }() * 2 + 1);
+
+            static constexpr std::array<lookup_slot, lookup_size> lookup_table = [] consteval {
+                std::array<lookup_slot, lookup_size> table{};
+                auto insert = [&table](std::string_view key, std::size_t ordinal) {
+                    std::size_t i = static_lookup_hash(key) & (lookup_size - 1);
+                    while (table[i].ordinal != npos)
+                        i = (i + 1) & (lookup_size - 1);
+                    table[i] = lookup_slot { key, ordinal };
+                };
+
+                for (std::size_t i = 0; i < data.size(); ++i)
+                {
+                    insert(data[i].m_name, i);
+                    for (std::string_view alias : data[i].m_aliases)
+                        insert(alias, i);
+                }
+
+                for (lookup_slot& slot : table)
+                    for (const lookup_slot& other : table)
+                        if (&slot != &other && slot.ordinal != npos && other.ordinal != npos &&
+                            utility::fold_case(slot.key) == utility::fold_case(other.key))
+                            slot.shared = true;
+
+                return table;
+            }();
+
+            // keys that differ only in case are each found by their own spelling, and by the first one probed otherwise
+            static std::size_t find(std::string_view name, bool case_sensitive)
+            {
+                std::size_t found = npos;
+                for (std::size_t i = static_lookup_hash(name) & (lookup_size - 1);
+                     lookup_table[i].ordinal != npos;
+                     i = (i + 1) & (lookup_size - 1))
+                {
+                    const lookup_slot& slot = lookup_table[i];
+                    if (!slot.shared || case_sensitive)
+                    {
+                        if (utility::sequals(name, slot.key, case_sensitive))
+                            return slot.ordinal;
+                    }
+                    else if (name == slot.key)
+                        return slot.ordinal;
+                    else if (found == npos && utility::iequals(name, slot.key))
+                        found = slot.ordinal;
+                }
+
+                return found;
+            }
+        };
+    }
+
+    // a module service over a fixed set of modules, known at compile time. the command table and the name lookup
+    // table are generated as constant data, and dispatch calls each command's member function directly.
+    template<template<typename> typename CoroutineTaskType, typename... Modules>
+    class basic_static_module_service : public module_service_base
+    {
+        static_assert((std::derived_from<Modules, module_base> && ...), "Modules must derive from module_base");
+        static_assert(utility::specialization_of<CoroutineTaskType<void>, detail::no_task> ||
+                      utility::is_awaitable<CoroutineTaskType<command_result>>);
+
+        using command_result_t = std::conditional_t<
+            utility::is_awaitable<CoroutineTaskType<command_result>>,
+            CoroutineTaskType<command_result>,
+            command_result>;
+        using table = detail::static_command_table<Modules...>;
+    public:
+        explicit basic_static_module_service(module_service_config config = {})
+            : module_service_base(std::move(config)) {}
+
+        template<typename M> requires (std::same_as<M, Modules> || ...)
+        M& module() { return std::get<M>(m_modules); }
+
+        template<typename M> requires (std::same_as<M, Modules> || ...)
+        const M& module() const { return std::get<M>(m_modules); }
+
+        bool has_command(std::string_view name) const
+        {
+            return table::find(name, config().case_sensitive_lookup) != table::npos;
+        }
+
+        // in coroutine mode each of these is the one frame the library adds to a dispatch. everything up to the
+        // command's own task is started without suspending, then awaited right here. context is who the command is
+        // run for, only static and dynamic preconditions are supported here.
+        CoroutineTaskType<command_result> run_command(std::string_view message, command_context context = {})
+            requires utility::is_awaitable<CoroutineTaskType<command_result>>
+        {
+            utility::dispatch_arena arena(arena_upstream());
+            utility::tokenizer tokenizer(config().separator_char, arena.resource());
+            if (!tokenize_message(message, tokenizer))
+                co_return command_result::from_error(command_error::unknown_command, "Unknown command");
+            co_return co_await started_command<command_result_t>(
+                start_command(tokenizer.tokens().front(), command_args(tokenizer, 1).with_context(context)),
+                config().throw_exceptions);
+        }
+
+        command_result run_command(std::string_view message, command_context context = {})
+            requires (!utility::is_awaitable<CoroutineTaskType<command_result>>)
+        {
+            utility::dispatch_arena arena(arena_upstream());
+            utility::tokenizer tokenizer(config().separator_char, arena.resource());
+            if (!tokenize_message(message, tokenizer))
+                return command_result::from_error(command_error::unknown_command, "Unknown command");
+            return run_command(tokenizer.tokens().front(), command_args(tokenizer, 1).with_context(context));
+        }
+
+        CoroutineTaskType<command_result> run_command(std::string_view name, std::span<const std::string_view> args,
+                                                      command_context context = {})
+            requires utility::is_awaitable<CoroutineTaskType<command_result>>
+        {
+            utility::dispatch_arena arena(arena_upstream());
+            co_return co_await started_command<command_result_t>(
+                start_command(name, command_args(args, arena.resource()).with_context(context)), config().throw_exceptions);
+        }
+
+        command_result run_command(std::string_view name, std::span<const std::string_view> args,
+                                   command_context context = {})
+            requires (!utility::is_awaitable<CoroutineTaskType<command_result>>)
+        {
+            utility::dispatch_arena arena(arena_upstream());
+            return run_command(name, command_args(args, arena.resource()).with_context(context));
+        }
+
+        CoroutineTaskType<command_result> run_command(std::string_view name, const command_args& args)
+            requires utility::is_awaitable<CoroutineTaskType<command_result>>
+        {
+            co_return co_await started_command<command_result_t>(start_command(name, args), config().throw_exceptions);
+        }
+
+        command_result run_command(std::string_view name, const command_args& args)
+            requires (!utility::is_awaitable<CoroutineTaskType<command_result>>)
+        {
+            expected_result<command_result> result = start_command(name, args);
+            return result ? std::move(*result) : std::move(result.error());
+        }
+    private:
+        std::tuple<Modules...> m_modules;
+
+        // finds and starts the command without waiting on it, see command_function::start
+        expected_result<command_result_t> start_command(std::string_view name, const command_args& args)
+        {
+            const std::size_t ordinal = table::find(name, config().case_sensitive_lookup);
+            if (ordinal == table::npos)
+                return std::unexpected(command_result::from_error(command_error::unknown_command, "Unknown command"));
+
+            if constexpr (table::has_preconditions)
+            {
+                if (std::optional<command_result> unmet = check_preconditions(ordinal, args.context()))
+                    return std::unexpected(std::move(*unmet));
+            }
+
+            if (args.size() < table::target_arg_counts[ordinal])
+            {
+                bad_argument_count arg_ex(table::data[ordinal].m_name, args.size(), table::target_arg_counts[ordinal]);
+                if (config().throw_exceptions)
+                    utility::throw_exception(std::move(arg_ex));
+                else
+                    return std::unexpected(command_result::from_error(std::move(arg_ex)));
+            }
+
+        #if __cpp_exceptions
+            if (!config().throw_exceptions)
+            {
+                try
+                {
+                    return dispatch(ordinal, args);
+                }
+                catch (const bad_command_argument& e)
+                {
+                    return std::unexpected(command_result::from_error(e));
+                }
+                catch (const std::exception& e)
+                {
+                    return std::unexpected(command_result::from_error(e));
+                }
+            }
+        #endif
+
+            return dispatch(ordinal, args);
+        }
+
+        std::optional<command_result> check_preconditions(std::size_t ordinal, const command_context& context)
+        {
+            template for (constexpr std::size_t I : table::ordinals)
+            {
+                constexpr std::meta::info fn = table::commands[I];
+                using Module = [:std::meta::parent_of(fn):];
+                static_assert(command_execution::async_precondition_count<fn, Module>() == 0,
+                              "Async preconditions need a module service in coroutine mode");
+
+                if constexpr (command_execution::has_sync_preconditions<fn, Module>())
+                {
+                    if (ordinal == I)
+                        return command_execution::check_preconditions<fn, Module>(context, this);
+                }
+            }
+            return std::nullopt;
+        }
+
+        expected_result<command_result_t> dispatch(std::size_t ordinal, const command_args& args)
+        {
+            template for (constexpr std::size_t I : table::ordinals)
+                if (ordinal == I)
+                    return invoke<I>(args);
+            std::unreachable();
+        }
+
+        template<std::size_t I>
+        expected_result<command_result_t> invoke(const command_args& args)
+        {
+            constexpr std::meta::info fn = table::commands[I];
+            using Module = [:std::meta::parent_of(fn):];
+            using Result = typename[:std::meta::return_type_of(fn):];
+            static_assert(std::same_as<Result, command_result_t>,
+                          "Command return type does not match the service's result type");
+
+            return command_execution::invoke_command<fn, utility::static_span<const std::meta::info>(std::meta::parameters_of(fn))>(
+                &std::get<Module>(m_modules), args, this);
+        }
+    };
+
+    template<typename... Modules>
+    using static_module_service = basic_static_module_service<detail::no_task, Modules...>;
+}
@@ -0,0 +1,28 @@
+#pragma once
+#include <array>
+#include <memory_resource>
+
+namespace patron
+{
+    namespace utility
+    {
+        // a monotonic arena for the temporaries of one dispatch. it starts out on a small inline buffer and only
+        // asks its upstream resource for more once that runs out. everything is released at once when it's destroyed.
+        class dispatch_arena
+        {
+        public:
+            static constexpr std::size_t inline_size = 1024;
+
+            explicit dispatch_arena(std::pmr::memory_resource* upstream = std::pmr::get_default_resource())
+                : m_resource(m_buffer.data(), m_buffer.size(), upstream) {}
+
+            dispatch_arena(const dispatch_arena&) = delete;
+            dispatch_arena& operator=(const dispatch_arena&) = delete;
+
+            std::pmr::memory_resource* resource() { return &m_resource; }
+        private:
+            alignas(std::max_align_t) std::array<std::byte, inline_size> m_buffer;
+            std::pmr::monotonic_buffer_resource m_resource;
+        };
+    }
+}
@@ -0,0 +1,140 @@
+#pragma once
+#include "case_fold.h"
+#include "strings.h"
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <meta>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace patron
+{
+    namespace utility
+    {
+        namespace detail
+        {
+            // names are hashed case-folded, so the same table serves case-sensitive and case-insensitive lookup
+            constexpr std::size_t enum_name_hash(std::string_view str, std::size_t seed)
+            {
+                std::size_t hash = 14695981039346656037ull ^ (seed * 0x9e3779b97f4a7c15ull);
+                for_each_folded_byte(str, [&hash](char c) {
+                    hash ^= static_cast<unsigned char>(c);
+                    hash *= 1099511628211ull;
+                });
+                return hash ^ (hash >> 29);
+            }
+
+            template<typename E>
+            struct enum_table
+            {
+                struct entry
+                {
+                    std::string_view name;
+                    E value{};
+                };
+
+                // the entries whose names fold to the one hashed here, more than one only for enumerators that differ
+                // only in case
+                struct slot
+                {
+                    std::size_t first = 0;
+                    std::size_t count = 0;
+                };
+
+                static constexpr std::span<const std::meta::info> enumerators =
+                    define_static_array(std::meta::enumerators_of(^^E));
+
+                // a seed that hashes every folded name into a slot of its own, found at compile time, so a lookup
+                // is one hash and, unless enumerators differ only in case, one compare
+                struct layout
+                {
+                    std::size_t size;
+                    std::size_t seed;
+                };
+
+                static constexpr layout hashing = [] consteval {
+                    std::vector<std::string> folded;
+                    for (std::meta::info e : enumerators)
+                    {
+                        std::string name = fold_case(std::meta::identifier_of(e));
+                        if (std::ranges::find(folded, name) == folded.end())
+                            folded.push_back(std::move(name));
+                    }
+
+                    for (std::size_t size = std::bit_ceil(std::max<std::size_t>(folded.size(), 1) * 2);; size *= 2)
+                    {
+                        for (std::size_t seed = 0; seed < 4096; ++seed)
+                        {
+                            std::vector<bool> used(size);
+                            bool collided = false;
+                            for (const std::string& name : folded)
+                            {
+                                std::size_t i = enum_name_hash(name, seed) & (size - 1);
+                                if (used[i])
+                                {
+                                    collided = true;
+                                    break;
+                                }
+                                used[i] = true;
+                            }
+
+                            if (!collided)
+                                return layout { size, seed };
+                        }
+                    }
+                }();
+
+                static constexpr std::size_t slot_of(std::string_view name)
+                {
+                    return enum_name_hash(name, hashing.seed) & (hashing.size - 1);
+                }
+
+                // in slot order, so the names a slot holds are next to each other, and in declaration order within one
+                static constexpr std::array<entry, enumerators.size()> entries = [] consteval {
+                    std::array<entry, enumerators.size()> declared{};
+                    std::size_t i = 0;
+                    template for (constexpr std::meta::info e : enumerators)
+                        declared[i++] = entry { std::define_static_string(std::meta::identifier_of(e)), [:e:] };
+
+                    std::array<entry, enumerators.size()> out{};
+                    std::size_t next = 0;
+                    for (std::size_t s = 0; s < hashing.size; ++s)
+                        for (const entry& e : declared)
+                            if (slot_of(e.name) == s)
+                                out[next++] = e;
+                    return out;
+                }();
+
+                static constexpr std::array<slot, hashing.size> slots = [] consteval {
+                    std::array<slot, hashing.size> out{};
+                    for (std::size_t i = 0; i < entries.size(); ++i)
+                    {
+                        slot& s = out[slot_of(entries[i].name)];
+                        if (s.count++ == 0)
+                            s.first = i;
+                    }
+                    return out;
+                }();
+            };
+        }
+
+        // the enumerator of E called str. an exact match always wins, so enumerators that differ only in case can
+        // still be told apart, but ignoring case a name that matches several of them is ambiguous and finds nothing.
+        template<typename E> requires std::is_enum_v<E>
+        std::optional<E> parse_enum(std::string_view str, bool case_sensitive)
+        {
+            using table = detail::enum_table<E>;
+            const typename table::slot& slot = table::slots[table::slot_of(str)];
+            std::span<const typename table::entry> names(table::entries.data() + slot.first, slot.count);
+            for (const typename table::entry& entry : names)
+                if (entry.name == str)
+                    return entry.value;
+
+            if (case_sensitive || names.size() != 1 || !sequals(str, names.front().name, false))
+                return std::nullopt;
+            return names.front().value;
+        }
+    }
+}
@@ -0,0 +1,92 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <new>
+#include <utility>
+
+namespace patron
+{
+    namespace utility
+    {
+        namespace detail
+        {
+            // free lists of frames binned by size. it's trivially destructible so it can still be reached by frames
+            // freed while the thread's other thread_locals are being destroyed, after its lists were released.
+            struct frame_pool
+            {
+                static constexpr std::size_t granularity = 64;
+                static constexpr std::size_t bin_count = 32;
+                static constexpr std::size_t max_cached = 64;
+
+                struct node
+                {
+                    node* next;
+                };
+
+                std::array<node*, bin_count> heads;
+                std::array<std::size_t, bin_count> counts;
+                bool closed;
+
+                static frame_pool& local()
+                {
+                    struct releaser
+                    {
+                        frame_pool& pool;
+
+                        ~releaser()
+                        {
+                            pool.closed = true;
+                            for (node*& head : pool.heads)
+                            {
+                                while (head)
+                                    ::operator delete(std::exchange(head, head->next));
+                            }
+                        }
+                    };
+
+                    thread_local constinit frame_pool pool {};
+                    thread_local releaser release { pool };
+                    return pool;
+                }
+            };
+        }
+
+        // inherit a promise type from this to have its coroutine frames recycled through a pool for the thread that
+        // frees them, rather than going back to the heap every time. frames over 2 KiB aren't pooled.
+        struct pooled_promise
+        {
+            static void* operator new(std::size_t size)
+            {
+                const std::size_t bin = (size - 1) / detail::frame_pool::granularity;
+                if (bin >= detail::frame_pool::bin_count)
+                    return ::operator new(size);
+
+                detail::frame_pool& pool = detail::frame_pool::local();
+                if (detail::frame_pool::node* node = pool.heads[bin])
+                {
+                    pool.heads[bin] = node->next;
+                    --pool.counts[bin];
+                    return node;
+                }
+
+                return ::operator new((bin + 1) * detail::frame_pool::granularity);
+            }
+
+            static void operator delete(void* ptr, std::size_t size) noexcept
+            {
+                const std::size_t bin = (size - 1) / detail::frame_pool::granularity;
+                if (bin >= detail::frame_pool::bin_count)
+                    return ::operator delete(ptr);
+
+                // frames can finish on another thread than they started on, so cap each bin rather than letting one
+                // thread collect every frame of a producer thread
+                detail::frame_pool& pool = detail::frame_pool::local();
+                if (pool.closed || pool.counts[bin] == detail::frame_pool::max_cached)
+                    return ::operator delete(ptr);
+
+                pool.heads[bin] = new (ptr) detail::frame_pool::node { pool.heads[bin] };
+                ++pool.counts[bin];
+            }
+        };
+    }
+}
@@ -0,0 +1,149 @@
+#pragma once
+#include "lexical_cast.h"
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <span>
+#include <vector>
+
+namespace patron
+{
+    namespace utility
+    {
+        // the first item of a list that didn't convert, and why
+        struct list_error
+        {
+            std::size_t index;
+            std::errc error;
+        };
+
+        namespace detail
+        {
+            // whether all eight bytes of chunk are ascii digits, and their value as an eight digit number. both work
+            // on the whole chunk at once, a 64-bit register standing in for a vector of eight bytes.
+            constexpr bool eight_digits(std::uint64_t chunk)
+            {
+                return ((chunk & 0xF0F0F0F0F0F0F0F0) |
+                        (((chunk + 0x0606060606060606) & 0xF0F0F0F0F0F0F0F0) >> 4)) == 0x3333333333333333;
+            }
+
+            constexpr std::uint32_t eight_digit_value(std::uint64_t chunk)
+            {
+                chunk -= 0x3030303030303030;
+                chunk = (chunk * 10) + (chunk >> 8);
+                chunk = (((chunk & 0x000000FF000000FF) * (100 + (1000000ull << 32))) +
+                         (((chunk >> 16) & 0x000000FF000000FF) * (1 + (10000ull << 32)))) >> 32;
+                return static_cast<std::uint32_t>(chunk);
+            }
+
+            // plain decimal digits, at most 19 of them so the sum can't overflow, eight at a time. anything else is
+            // left to parse_number, which gives the same results and errors as lexical_cast.
+            template<std::integral T>
+            std::expected<T, std::errc> parse_list_integer(std::string_view s)
+            {
+                const bool negative = std::signed_integral<T> && s.starts_with('-');
+                std::string_view digits = negative ? s.substr(1) : s;
+                if constexpr (std::endian::native == std::endian::little)
+                {
+                    if (!digits.empty() && digits.size() <= 19)
+                    {
+                        // whole chunks from the front, then the last few digits as one more chunk padded with
+                        // leading zeros, read back from the end of the token when it's long enough to
+                        constexpr std::uint64_t powers[] = { 1, 10, 100, 1000, 10000, 100000, 1000000, 10000000 };
+                        std::uint64_t value = 0;
+                        const char* p = digits.data();
+                        const std::size_t tail = digits.size() % 8;
+                        bool valid = true;
+                        for (const char* end = p + digits.size() - tail; p != end && valid; p += 8)
+                        {
+                            std::uint64_t chunk;
+                            std::memcpy(&chunk, p, sizeof(chunk));
+                            valid = eight_digits(chunk);
+                            value = value * 100000000 + eight_digit_value(chunk);
+                        }
+
+                        if (valid && tail != 0)
+                        {
+                            std::uint64_t chunk = 0x3030303030303030;
+                            const std::uint64_t padding = ~0ull >> (tail * 8);
+                            if (digits.size() >= 8)
+                            {
+                                std::memcpy(&chunk, p + tail - 8, sizeof(chunk));
+                                chunk = (chunk & ~padding) | (0x3030303030303030 & padding);
+                            }
+                            else
+                                std::memcpy(reinterpret_cast<char*>(&chunk) + 8 - tail, p, tail);
+                            valid = eight_digits(chunk);
+                            value = value * powers[tail] + eight_digit_value(chunk);
+                        }
+
+                        if (valid)
+                        {
+                            using U = std::make_unsigned_t<T>;
+                            const std::uint64_t limit = static_cast<U>(std::numeric_limits<T>::max()) + (negative ? 1 : 0);
+                            if (value > limit)
+                                return std::unexpected(std::errc::result_out_of_range);
+                            return static_cast<T>(negative ? static_cast<U>(U(0) - static_cast<U>(value)) : static_cast<U>(value));
+                        }
+                    }
+                }
+
+                return parse_number<T>(s);
+            }
+        }
+
+        template<typename T>
+        concept list_integer = std::integral<T> && !std::same_as<T, bool> && !std::same_as<T, char>;
+
+        // converts every token to T, writing them to out, which has room for all of them. stops at the first one that
+        // doesn't convert, with the ones before it written.
+        template<list_integer T>
+        std::expected<void, list_error> parse_integers(std::span<const std::string_view> tokens, T* out)
+        {
+            for (std::size_t i = 0; i < tokens.size(); ++i)
+            {
+                std::expected<T, std::errc> value = detail::parse_list_integer<T>(tokens[i]);
+                if (!value)
+                    return std::unexpected(list_error { i, value.error() });
+                out[i] = *value;
+            }
+            return {};
+        }
+
+        // the same, appending to out, which is left with the ones before a failure
+        template<list_integer T, typename Allocator>
+        std::expected<void, list_error> parse_integers(std::span<const std::string_view> tokens, std::vector<T, Allocator>& out)
+        {
+            const std::size_t size = out.size();
+            out.resize(size + tokens.size());
+            std::expected<void, list_error> result = parse_integers(tokens, out.data() + size);
+            if (!result)
+                out.resize(size + result.error().index);
+            return result;
+        }
+
+        // the same for a list in one string, like a remainder argument, with items split by runs of separator
+        template<list_integer T, typename Allocator>
+        std::expected<void, list_error> parse_integer_list(std::string_view text, char separator, std::vector<T, Allocator>& out)
+        {
+            out.reserve(out.size() + static_cast<std::size_t>(std::ranges::count(text, separator)) + 1);
+            std::size_t index = 0;
+            while (true)
+            {
+                const std::size_t start = text.find_first_not_of(separator);
+                if (start == std::string_view::npos)
+                    return {};
+                text.remove_prefix(start);
+
+                const std::size_t end = std::min(text.find(separator), text.size());
+                std::expected<T, std::errc> value = detail::parse_list_integer<T>(text.substr(0, end));
+                if (!value)
+                    return std::unexpected(list_error { index, value.error() });
+                out.push_back(*value);
+
+                text.remove_prefix(end);
+                ++index;
+            }
+        }
+    }
+}
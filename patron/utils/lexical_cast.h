@@ -1,16 +1,108 @@
 #pragma once
+#include "throw.h"
+#include <algorithm>
 #include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <expected>
 #include <format>
+#include <limits>
 #include <sstream>
+#include <string_view>
+#include <utility>
 
 namespace patron
 {
     namespace utility
     {
+        // a type's lexical_cast from text, found by argument-dependent lookup:
+        //   std::expected<T, std::errc> try_parse(std::string_view, utility::parse_tag<T>)
+        // declared next to T, this is how user types get converted without a stream
+        template<typename T>
+        struct parse_tag {};
+
+        // specialized to true for a type only operator>> can read, to let lexical_cast go through a
+        // std::stringstream for it. that's off by default, the stream is locale-aware and allocates every time.
+        template<typename T>
+        inline constexpr bool enable_stream_cast = false;
+
         namespace detail
         {
             template<typename T>
             concept StringViewLike = std::convertible_to<T, std::string_view>;
+
+            template<typename T>
+            concept Parsable = requires(std::string_view s) {
+                { try_parse(s, parse_tag<T>{}) } -> std::same_as<std::expected<T, std::errc>>;
+            };
+
+            // bool and char are read as words and characters, not as numbers
+            template<typename T>
+            concept Number = std::is_arithmetic_v<T> && !std::same_as<T, bool> && !std::same_as<T, char>;
+
+            constexpr char to_lower(char c)
+            {
+                return c >= 'A' && c <= 'Z' ? static_cast<char>(c - 'A' + 'a') : c;
+            }
+
+            constexpr bool iequals(std::string_view s, std::string_view lower)
+            {
+                return s.size() == lower.size() && std::ranges::equal(s, lower, {}, to_lower);
+            }
+
+            // the whole of s as a number, where integers can also be written in hex or binary, like -0x1F or 0b101
+            template<Number T>
+            constexpr std::expected<T, std::errc> parse_number(std::string_view s)
+            {
+                if constexpr (std::integral<T>)
+                {
+                    const bool negative = s.starts_with('-');
+                    std::string_view digits = negative ? s.substr(1) : s;
+                    if (digits.size() > 2 && digits[0] == '0' && (to_lower(digits[1]) == 'x' || to_lower(digits[1]) == 'b'))
+                    {
+                        const int base = to_lower(digits[1]) == 'x' ? 16 : 2;
+                        digits.remove_prefix(2);
+                        if (digits.starts_with('-') || (negative && std::unsigned_integral<T>))
+                            return std::unexpected(std::errc::invalid_argument);
+
+                        using U = std::make_unsigned_t<T>;
+                        U magnitude;
+                        auto [ptr, ec] = std::from_chars(digits.data(), digits.data() + digits.size(), magnitude, base);
+                        if (ec != std::errc())
+                            return std::unexpected(ec);
+                        if (ptr != digits.data() + digits.size())
+                            return std::unexpected(std::errc::invalid_argument);
+
+                        const U limit = static_cast<U>(std::numeric_limits<T>::max()) + (negative ? 1 : 0);
+                        if (magnitude > limit)
+                            return std::unexpected(std::errc::result_out_of_range);
+                        return static_cast<T>(negative ? static_cast<U>(U(0) - magnitude) : magnitude);
+                    }
+                }
+
+                T n;
+                auto [ptr, ec] = std::from_chars(s.data(), s.data() + s.size(), n);
+                if (ec != std::errc())
+                    return std::unexpected(ec);
+                if (ptr != s.data() + s.size())
+                    return std::unexpected(std::errc::invalid_argument);
+                return n;
+            }
+
+            // how many nanoseconds a duration unit stands for, zero when unit isn't one
+            constexpr std::int64_t duration_unit(std::string_view unit)
+            {
+                constexpr std::pair<std::string_view, std::int64_t> units[] = {
+                    { "ns", 1 }, { "us", 1'000 }, { "ms", 1'000'000 }, { "s", 1'000'000'000 },
+                    { "m", 60'000'000'000 }, { "h", 3'600'000'000'000 }, { "d", 86'400'000'000'000 },
+                    { "w", 604'800'000'000'000 }
+                };
+
+                for (auto [name, nanoseconds] : units)
+                    if (iequals(unit, name))
+                        return nanoseconds;
+                return 0;
+            }
         }
 
         class bad_lexical_cast : public std::bad_cast
@@ -25,18 +117,27 @@ namespace patron
 
         namespace casters
         {
+            // what none of the specializations below cover: types with their own try_parse, then ones that opted
+            // into the stream. anything else has no try_cast, so it can't be lexical cast at all.
             template<typename Target, typename Source>
             struct lexical_caster
             {
-                static Target cast(const Source& s)
+                static constexpr std::expected<Target, std::errc> try_cast(std::string_view s)
+                    requires detail::StringViewLike<Source> && detail::Parsable<Target>
+                {
+                    return try_parse(s, parse_tag<Target>{});
+                }
+
+                static std::expected<Target, std::errc> try_cast(const Source& s)
+                    requires (!(detail::StringViewLike<Source> && detail::Parsable<Target>)) && enable_stream_cast<Target>
                 {
                     std::stringstream ss;
                     if ((ss << s).fail())
-                        throw bad_lexical_cast(typeid(Source).name());
+                        return std::unexpected(std::errc::invalid_argument);
 
                     Target t;
                     if ((ss >> t).fail() || !(ss >> std::ws).eof())
-                        throw bad_lexical_cast(typeid(Source).name(), typeid(Target).name());
+                        return std::unexpected(std::errc::invalid_argument);
 
                     return t;
                 }
@@ -45,7 +146,7 @@ namespace patron
             template<typename T>
             struct lexical_caster<T, T>
             {
-                static constexpr const T& cast(const T& s)
+                static constexpr std::expected<T, std::errc> try_cast(const T& s)
                 {
                     return s;
                 }
@@ -54,7 +155,7 @@ namespace patron
             template<>
             struct lexical_caster<std::string, std::string>
             {
-                static constexpr const std::string& cast(const std::string& s)
+                static constexpr std::expected<std::string, std::errc> try_cast(const std::string& s)
                 {
                     return s;
                 }
@@ -63,7 +164,7 @@ namespace patron
             template<detail::StringViewLike StringViewLike>
             struct lexical_caster<std::string, StringViewLike>
             {
-                static constexpr std::string cast(std::string_view s)
+                static constexpr std::expected<std::string, std::errc> try_cast(std::string_view s)
                 {
                     return std::string(s);
                 }
@@ -72,7 +173,7 @@ namespace patron
             template<>
             struct lexical_caster<std::string, bool>
             {
-                static constexpr std::string cast(bool b)
+                static constexpr std::expected<std::string, std::errc> try_cast(bool b)
                 {
                     return b ? "true" : "false";
                 }
@@ -81,7 +182,7 @@ namespace patron
             template<typename Source>
             struct lexical_caster<std::string, Source>
             {
-                static std::string cast(const Source& s)
+                static std::expected<std::string, std::errc> try_cast(const Source& s)
                 {
                     if constexpr (std::formattable<Source, char>)
                     {
@@ -91,28 +192,102 @@ namespace patron
                     {
                         std::ostringstream oss;
                         if ((oss << s).fail())
-                            throw bad_lexical_cast(typeid(Source).name());
+                            return std::unexpected(std::errc::invalid_argument);
                         return oss.str();
                     }
                 }
             };
 
-            template<typename Number, detail::StringViewLike StringViewLike> requires std::is_arithmetic_v<Number>
+            template<detail::Number Number, detail::StringViewLike StringViewLike>
             struct lexical_caster<Number, StringViewLike>
             {
-                static constexpr Number cast(std::string_view s)
+                static constexpr std::expected<Number, std::errc> try_cast(std::string_view s)
+                {
+                    return detail::parse_number<Number>(s);
+                }
+            };
+
+            // true/false, yes/no, on/off or 1/0, in any case
+            template<detail::StringViewLike StringViewLike>
+            struct lexical_caster<bool, StringViewLike>
+            {
+                static constexpr std::expected<bool, std::errc> try_cast(std::string_view s)
                 {
-                    Number n;
-                    if (auto [_, ec] = std::from_chars(s.data(), s.data() + s.size(), n); ec != std::errc())
-                        throw bad_lexical_cast("string", typeid(Number).name());
-                    return n;
+                    for (std::string_view word : { "true", "yes", "on", "1" })
+                        if (detail::iequals(s, word))
+                            return true;
+                    for (std::string_view word : { "false", "no", "off", "0" })
+                        if (detail::iequals(s, word))
+                            return false;
+                    return std::unexpected(std::errc::invalid_argument);
+                }
+            };
+
+            template<detail::StringViewLike StringViewLike>
+            struct lexical_caster<char, StringViewLike>
+            {
+                static constexpr std::expected<char, std::errc> try_cast(std::string_view s)
+                {
+                    if (s.size() != 1)
+                        return std::unexpected(std::errc::invalid_argument);
+                    return s.front();
+                }
+            };
+
+            // a count followed by a unit, any number of times, like "10m" or "1h30s". the units go from ns, us and ms
+            // up through s, m and h to d and w. a bare count is in the duration's own unit. an integer duration has
+            // to hold the total exactly, so "1500ms" is no number of seconds.
+            template<typename Rep, typename Period, detail::StringViewLike StringViewLike>
+            struct lexical_caster<std::chrono::duration<Rep, Period>, StringViewLike>
+            {
+                using duration = std::chrono::duration<Rep, Period>;
+
+                static constexpr std::expected<duration, std::errc> try_cast(std::string_view s)
+                {
+                    if (!s.empty() && std::ranges::all_of(s, [](char c) { return c >= '0' && c <= '9'; }))
+                        return detail::parse_number<Rep>(s).transform([](Rep count) { return duration(count); });
+
+                    if (s.empty())
+                        return std::unexpected(std::errc::invalid_argument);
+
+                    std::int64_t total = 0;
+                    while (!s.empty())
+                    {
+                        std::int64_t count;
+                        auto [ptr, ec] = std::from_chars(s.data(), s.data() + s.size(), count);
+                        if (ec != std::errc() || count < 0)
+                            return std::unexpected(ec != std::errc() ? ec : std::errc::invalid_argument);
+                        s.remove_prefix(ptr - s.data());
+
+                        std::size_t unit_size = 0;
+                        while (unit_size < s.size() && detail::to_lower(s[unit_size]) >= 'a' && detail::to_lower(s[unit_size]) <= 'z')
+                            ++unit_size;
+
+                        const std::int64_t unit = detail::duration_unit(s.substr(0, unit_size));
+                        if (unit == 0)
+                            return std::unexpected(std::errc::invalid_argument);
+                        s.remove_prefix(unit_size);
+
+                        if (count > (std::numeric_limits<std::int64_t>::max() - total) / unit)
+                            return std::unexpected(std::errc::result_out_of_range);
+                        total += count * unit;
+                    }
+
+                    const std::chrono::nanoseconds exact(total);
+                    const duration result = std::chrono::duration_cast<duration>(exact);
+                    if constexpr (!std::chrono::treat_as_floating_point_v<Rep>)
+                    {
+                        if (result != exact)
+                            return std::unexpected(std::errc::invalid_argument);
+                    }
+                    return result;
                 }
             };
 
             template<typename Number> requires std::is_arithmetic_v<Number>
             struct lexical_caster<std::string, Number>
             {
-                static constexpr std::string cast(Number n)
+                static constexpr std::expected<std::string, std::errc> try_cast(Number n)
                 {
                     // the "magic numbers" here are to leave room for other characters such as "+-e,."
                     // floating point types need a larger size to account for the decimal part
@@ -123,31 +298,29 @@ namespace patron
                     char buf[bufsize];
                     const auto res = std::to_chars(buf, buf + bufsize, n);
                     if (res.ec != std::errc())
-                        throw bad_lexical_cast(typeid(Number).name(), "string");
+                        return std::unexpected(res.ec);
 
                     return std::string(buf, res.ptr);
                 }
             };
         }
 
+        // never throws on bad input, failures come back as the error code of the conversion
+        template<typename Target, typename Source>
+            requires requires(const Source& s) { casters::lexical_caster<Target, Source>::try_cast(s); }
+        inline constexpr std::expected<Target, std::errc> try_lexical_cast(const Source& s)
+        {
+            return casters::lexical_caster<Target, Source>::try_cast(s);
+        }
+
         template<typename Target, typename Source>
         inline constexpr Target lexical_cast(const Source& s, bool exceptions = true)
         {
+            if (std::expected<Target, std::errc> result = try_lexical_cast<Target>(s))
+                return std::move(*result);
             if (exceptions)
-            {
-                return casters::lexical_caster<Target, Source>::cast(s);
-            }
-            else
-            {
-                try
-                {
-                    return casters::lexical_caster<Target, Source>::cast(s);
-                }
-                catch (const bad_lexical_cast& e)
-                {
-                    return Target{};
-                }
-            }
+                throw_exception(bad_lexical_cast(typeid(Source).name(), typeid(Target).name()));
+            return Target{};
         }
     }
 }
@@ -67,13 +67,20 @@ namespace patron
             }
         };
 
-        consteval std::optional<std::meta::info> find_annotation(std::meta::info r, std::meta::info a)
+        namespace detail
+        {
+            // not constexpr, so reaching a call to it at compile time fails the build, naming the problem, without
+            // needing exceptions
+            inline void inconsistent_annotations() {}
+        }
+
+        consteval std::optional<std::meta::info> find_annotation(std::meta::info r, std::meta::info type)
         {
             std::optional<std::meta::info> res;
-            for (std::meta::info a : std::meta::annotations_of(r, a))
+            for (std::meta::info a : std::meta::annotations_of(r, type))
             {
                 if (res && *res != a)
-                    throw "inconsistent annotations";
+                    detail::inconsistent_annotations();
                 res = a;
             }
 
@@ -0,0 +1,71 @@
+#pragma once
+#include <array>
+#include <memory_resource>
+#include <span>
+#include <vector>
+
+namespace patron
+{
+    namespace utility
+    {
+        // a vector of trivially copyable elements that keeps its first N elements inline and only allocates from its
+        // memory resource once it grows past them
+        template<typename T, std::size_t N>
+        class small_vector
+        {
+            static_assert(std::is_trivially_copyable_v<T>, "small_vector only holds trivially copyable types");
+        public:
+            using value_type = T;
+
+            explicit small_vector(std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+                : m_overflow(resource) {}
+
+            small_vector(const small_vector&) = delete;
+            small_vector& operator=(const small_vector&) = delete;
+
+            void push_back(const T& value)
+            {
+                if (m_overflow.empty() && m_size < N)
+                {
+                    m_inline[m_size++] = value;
+                    return;
+                }
+
+                if (m_overflow.empty())
+                {
+                    m_overflow.reserve(N * 2);
+                    m_overflow.assign(m_inline.begin(), m_inline.end());
+                }
+
+                m_overflow.push_back(value);
+                ++m_size;
+            }
+
+            void clear()
+            {
+                m_overflow.clear();
+                m_size = 0;
+            }
+
+            T* data() { return m_overflow.empty() ? m_inline.data() : m_overflow.data(); }
+            const T* data() const { return m_overflow.empty() ? m_inline.data() : m_overflow.data(); }
+            std::size_t size() const { return m_size; }
+            bool empty() const { return m_size == 0; }
+
+            T& operator[](std::size_t idx) { return data()[idx]; }
+            const T& operator[](std::size_t idx) const { return data()[idx]; }
+
+            T* begin() { return data(); }
+            T* end() { return data() + m_size; }
+            const T* begin() const { return data(); }
+            const T* end() const { return data() + m_size; }
+
+            operator std::span<T>() { return std::span(data(), m_size); }
+            operator std::span<const T>() const { return std::span(data(), m_size); }
+        private:
+            std::array<T, N> m_inline;
+            std::pmr::vector<T> m_overflow;
+            std::size_t m_size{};
+        };
+    }
+}
@@ -0,0 +1,70 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+
+namespace patron
+{
+    namespace utility
+    {
+        // a value that's only ever replaced whole, read-copy-update style. readers load the current snapshot without
+        // locking and keep it alive for as long as they hold it, writers copy it, change the copy and publish that.
+        template<typename T>
+        class snapshot_cell
+        {
+        public:
+            explicit snapshot_cell(T initial = {})
+                : m_current(std::make_shared<const T>(std::move(initial))) {}
+
+            snapshot_cell(const snapshot_cell&) = delete;
+            snapshot_cell& operator=(const snapshot_cell&) = delete;
+
+            std::shared_ptr<const T> load() const { return m_current.load(std::memory_order_acquire); }
+
+            // bumped after every publish, so a reader caching a snapshot can tell when it has gone stale
+            std::uint64_t version() const { return m_version.load(std::memory_order_acquire); }
+
+            // writers are serialized. if fn throws, nothing is published.
+            template<typename F>
+            void update(F&& fn)
+            {
+                std::lock_guard lock(m_write_mutex);
+                std::shared_ptr<T> next = std::make_shared<T>(*m_current.load(std::memory_order_relaxed));
+                std::forward<F>(fn)(*next);
+                m_current.store(std::move(next), std::memory_order_release);
+                m_version.fetch_add(1, std::memory_order_release);
+            }
+        private:
+            std::atomic<std::shared_ptr<const T>> m_current;
+            std::atomic<std::uint64_t> m_version;
+            std::mutex m_write_mutex;
+        };
+
+        // one thread's cached reference to a cell's snapshot, so reading it doesn't touch the shared reference
+        // count. an old snapshot is freed once every thread that cached it has refreshed, released it or exited.
+        template<typename T>
+        class snapshot_reader
+        {
+        public:
+            const T& refresh(const snapshot_cell<T>& cell)
+            {
+                const std::uint64_t version = cell.version();
+                if (!m_snapshot || version != m_version)
+                {
+                    m_snapshot = cell.load();
+                    m_version = version;
+                }
+                return *m_snapshot;
+            }
+
+            const T& get() const { return *m_snapshot; }
+
+            // drops the cached reference, for when the thread may not read the cell again for a while
+            void release() { m_snapshot.reset(); }
+        private:
+            std::uint64_t m_version{};
+            std::shared_ptr<const T> m_snapshot;
+        };
+    }
+}
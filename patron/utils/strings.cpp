@@ -1,6 +1,9 @@
 #include "strings.h"
+#include "case_fold.h"
 #include <algorithm>
-#include <cctype>
+#include <bit>
+#include <cstdint>
+#include <cstring>
 
 #if defined(__has_include) && __has_include(<cxxabi.h>) && !defined(__GABIXX_CXXABI_H__)
 # include <cxxabi.h>
@@ -8,6 +11,14 @@
 # define NEED_DEMANGLE
 #endif
 
+#if defined(__x86_64__) || defined(_M_X64) || (defined(__i386__) && defined(__SSE2__))
+# include <immintrin.h>
+# define HAVE_SSE2
+# if defined(__GNUC__) || defined(__clang__)
+#  define HAVE_AVX2_DISPATCH
+# endif
+#endif
+
 namespace patron
 {
     namespace utility
@@ -24,16 +35,173 @@ namespace patron
         #endif
         }
 
+        namespace
+        {
+            // each of these returns the first index below n where the ASCII-folded bytes of a and b differ, or where
+            // either byte isn't ASCII, or n when there's no such index
+            std::size_t ascii_mismatch_scalar(const char* a, const char* b, std::size_t n)
+            {
+                constexpr std::uint64_t high_bits = 0x8080808080808080ull;
+                constexpr std::uint64_t ones = 0x0101010101010101ull;
+
+                // eight bytes at a time: flag the bytes in 'A'..'Z' and set their 0x20 bit
+                auto fold = [](std::uint64_t x) {
+                    const std::uint64_t heptets = x & ~high_bits;
+                    const std::uint64_t above_a = heptets + ones * (0x80 - 'A');
+                    const std::uint64_t above_z = heptets + ones * (0x80 - 'Z' - 1);
+                    return x | (((above_a & ~above_z) & ~x & high_bits) >> 2);
+                };
+
+                std::size_t i = 0;
+                for (; i + 8 <= n; i += 8)
+                {
+                    std::uint64_t x;
+                    std::uint64_t y;
+                    std::memcpy(&x, a + i, 8);
+                    std::memcpy(&y, b + i, 8);
+                    if (((x | y) & high_bits) || fold(x) != fold(y))
+                        break;
+                }
+
+                for (; i < n; ++i)
+                {
+                    const unsigned char x = static_cast<unsigned char>(a[i]);
+                    const unsigned char y = static_cast<unsigned char>(b[i]);
+                    if ((x | y) >= 0x80 || simple_fold(x) != simple_fold(y))
+                        return i;
+                }
+
+                return n;
+            }
+
+        #ifdef HAVE_SSE2
+            inline __m128i fold_sse2(__m128i x)
+            {
+                // bytes at or above 0x80 are negative as signed bytes, so they never land in the range
+                const __m128i upper = _mm_and_si128(_mm_cmpgt_epi8(x, _mm_set1_epi8('A' - 1)),
+                                                    _mm_cmplt_epi8(x, _mm_set1_epi8('Z' + 1)));
+                return _mm_or_si128(x, _mm_and_si128(upper, _mm_set1_epi8(0x20)));
+            }
+
+            std::size_t ascii_mismatch_sse2(const char* a, const char* b, std::size_t n)
+            {
+                std::size_t i = 0;
+                for (; i + 16 <= n; i += 16)
+                {
+                    const __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+                    const __m128i y = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i));
+                    const unsigned mismatch = ~static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(fold_sse2(x), fold_sse2(y)))) |
+                                              static_cast<unsigned>(_mm_movemask_epi8(_mm_or_si128(x, y)));
+                    if (mismatch & 0xFFFF)
+                        return i + std::countr_zero(mismatch & 0xFFFF);
+                }
+
+                return i + ascii_mismatch_scalar(a + i, b + i, n - i);
+            }
+        #endif
+
+        #ifdef HAVE_AVX2_DISPATCH
+            __attribute__((target("avx2")))
+            inline __m256i fold_avx2(__m256i x)
+            {
+                const __m256i upper = _mm256_and_si256(_mm256_cmpgt_epi8(x, _mm256_set1_epi8('A' - 1)),
+                                                       _mm256_cmpgt_epi8(_mm256_set1_epi8('Z' + 1), x));
+                return _mm256_or_si256(x, _mm256_and_si256(upper, _mm256_set1_epi8(0x20)));
+            }
+
+            __attribute__((target("avx2")))
+            std::size_t ascii_mismatch_avx2(const char* a, const char* b, std::size_t n)
+            {
+                std::size_t i = 0;
+                for (; i + 32 <= n; i += 32)
+                {
+                    const __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+                    const __m256i y = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i));
+                    const std::uint32_t mismatch = ~static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(fold_avx2(x), fold_avx2(y)))) |
+                                                   static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_or_si256(x, y)));
+                    if (mismatch)
+                        return i + std::countr_zero(mismatch);
+                }
+
+                return i + ascii_mismatch_sse2(a + i, b + i, n - i);
+            }
+        #endif
+
+            using ascii_mismatch_fn = std::size_t(*)(const char*, const char*, std::size_t);
+
+            ascii_mismatch_fn select_ascii_mismatch()
+            {
+            #if defined(HAVE_AVX2_DISPATCH)
+                if (__builtin_cpu_supports("avx2"))
+                    return ascii_mismatch_avx2;
+            #endif
+            #if defined(HAVE_SSE2)
+                return ascii_mismatch_sse2;
+            #else
+                return ascii_mismatch_scalar;
+            #endif
+            }
+
+            std::size_t ascii_mismatch(const char* a, const char* b, std::size_t n)
+            {
+                // picked on first use, since another TU's static initialization may compare strings before this
+                // one's has run
+                static const ascii_mismatch_fn impl = select_ascii_mismatch();
+                return impl(a, b, n);
+            }
+
+            // compares code point by code point under simple case folding, for strings that aren't all ASCII
+            bool unicode_iequals(std::string_view s1, std::string_view s2)
+            {
+                std::size_t i = 0;
+                std::size_t j = 0;
+                while (i < s1.size() && j < s2.size())
+                {
+                    char32_t c1;
+                    char32_t c2;
+                    i += detail::decode_utf8(s1, i, c1);
+                    j += detail::decode_utf8(s2, j, c2);
+                    if (simple_fold(c1) != simple_fold(c2))
+                        return false;
+                }
+
+                return i == s1.size() && j == s2.size();
+            }
+        }
+
         bool iequals(std::string_view s1, std::string_view s2)
         {
-            return std::ranges::equal(s1, s2, [](unsigned char a, unsigned char b) {
-                return std::tolower(a) == std::tolower(b);
-            });
+            const std::size_t common = std::min(s1.size(), s2.size());
+            const std::size_t i = ascii_mismatch(s1.data(), s2.data(), common);
+            if (i == common)
+                return s1.size() == s2.size();
+
+            // the prefix before i is ASCII and equal in both. two differing ASCII bytes settle it, otherwise
+            // folding may change byte lengths, so compare the rest by code point.
+            if ((static_cast<unsigned char>(s1[i]) | static_cast<unsigned char>(s2[i])) < 0x80)
+                return false;
+            return unicode_iequals(s1.substr(i), s2.substr(i));
         }
 
         bool sequals(std::string_view s1, std::string_view s2, bool case_sensitive)
         {
             return case_sensitive ? s1 == s2 : iequals(s1, s2);
         }
+
+        std::size_t shash(std::string_view str, bool case_sensitive)
+        {
+            // FNV-1a. case-insensitive hashes go over the folded bytes, so strings iequals matches hash equally.
+            std::size_t hash = 14695981039346656037ull;
+            auto add = [&hash](char c) {
+                hash ^= static_cast<unsigned char>(c);
+                hash *= 1099511628211ull;
+            };
+
+            if (case_sensitive)
+                std::ranges::for_each(str, add);
+            else
+                for_each_folded_byte(str, add);
+            return hash;
+        }
     }
 }
@@ -6,7 +6,9 @@ namespace patron
     namespace utility
     {
         std::string demangle(std::string_view name);
+        // case-insensitive under Unicode simple case folding. ASCII runs are compared a vector at a time.
         bool iequals(std::string_view s1, std::string_view s2);
         bool sequals(std::string_view s1, std::string_view s2, bool case_sensitive);
+        std::size_t shash(std::string_view str, bool case_sensitive);
     }
 }
@@ -0,0 +1,22 @@
+#pragma once
+#include <cstdlib>
+#include <utility>
+
+namespace patron
+{
+    namespace utility
+    {
+        // throws e, or aborts in builds with exceptions disabled. code that has to work without exceptions should
+        // report failures through return values and only reach this when it has been asked to throw.
+        template<typename E>
+        [[noreturn]] void throw_exception(E&& e)
+        {
+        #if __cpp_exceptions
+            throw std::forward<E>(e);
+        #else
+            (void)e;
+            std::abort();
+        #endif
+        }
+    }
+}
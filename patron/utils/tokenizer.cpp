@@ -0,0 +1,76 @@
+#include "tokenizer.h"
+
+namespace patron
+{
+    namespace utility
+    {
+        void tokenizer::tokenize(std::string_view input)
+        {
+            m_offsets.clear();
+            m_tokens.clear();
+            m_unescaped.clear();
+
+            std::size_t end = 0;
+            std::size_t pos = 0;
+            while (pos < input.size())
+            {
+                if (input[pos] == m_separator)
+                {
+                    ++pos;
+                    continue;
+                }
+
+                const std::size_t start = pos;
+                const bool quoted = input[pos] == '"';
+                if (quoted)
+                    ++pos;
+
+                const std::size_t value_start = pos;
+                bool escaped = false;
+                while (pos < input.size())
+                {
+                    if (input[pos] == '\\' && pos + 1 < input.size())
+                    {
+                        escaped = true;
+                        pos += 2;
+                    }
+                    else if (quoted ? input[pos] == '"' : input[pos] == m_separator)
+                    {
+                        break;
+                    }
+                    else
+                    {
+                        ++pos;
+                    }
+                }
+
+                std::string_view value = input.substr(value_start, pos - value_start);
+                if (quoted && pos < input.size())
+                    ++pos; // closing quote
+
+                if (escaped)
+                {
+                    // reserve the whole input up front so earlier unescaped tokens never move
+                    if (m_unescaped.capacity() < input.size())
+                        m_unescaped.reserve(input.size());
+
+                    const std::size_t unescaped_start = m_unescaped.size();
+                    for (std::size_t i = 0; i < value.size(); ++i)
+                    {
+                        if (value[i] == '\\' && i + 1 < value.size())
+                            ++i;
+                        m_unescaped += value[i];
+                    }
+
+                    value = std::string_view(m_unescaped).substr(unescaped_start);
+                }
+
+                m_offsets.push_back(start);
+                m_tokens.push_back(value);
+                end = pos;
+            }
+
+            m_source = input.substr(0, end);
+        }
+    }
+}
@@ -0,0 +1,36 @@
+#pragma once
+#include "small_vector.h"
+#include <string>
+
+namespace patron
+{
+    namespace utility
+    {
+        // splits a message into arguments without copying it. arguments can be wrapped in double quotes to keep
+        // separators in them, and a backslash escapes the character after it. only arguments that actually contain
+        // escapes are copied, into a buffer owned by the tokenizer.
+        class tokenizer
+        {
+        public:
+            static constexpr std::size_t inline_tokens = 16;
+
+            explicit tokenizer(char separator = ' ', std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+                : m_separator(separator), m_offsets(resource), m_tokens(resource), m_unescaped(resource) {}
+
+            void tokenize(std::string_view input);
+
+            // the raw input, up to the end of the last token
+            std::string_view source() const { return m_source; }
+            // where each token starts in source(), opening quote included
+            std::span<const std::size_t> offsets() const { return m_offsets; }
+            std::span<const std::string_view> tokens() const { return m_tokens; }
+            std::pmr::memory_resource* resource() const { return m_unescaped.get_allocator().resource(); }
+        private:
+            char m_separator;
+            std::string_view m_source;
+            small_vector<std::size_t, inline_tokens> m_offsets;
+            small_vector<std::string_view, inline_tokens> m_tokens;
+            std::pmr::string m_unescaped;
+        };
+    }
+}